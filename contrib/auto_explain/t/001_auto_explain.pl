@@ -28,6 +28,13 @@ $node->safe_psql("postgres", "SELECT * FROM pg_proc;");
 $node->safe_psql("postgres",
 	"SELECT * FROM pg_class WHERE relname = 'pg_class';");
 
+# sampled timing, back in text mode
+$node->append_conf('postgresql.conf', "auto_explain.log_format = text");
+$node->append_conf('postgresql.conf', "auto_explain.log_timing_sampled = on");
+$node->reload;
+$node->safe_psql("postgres",
+	"SELECT count(*) FROM generate_series(1, 10000) g WHERE g % 3 = 0;");
+
 $node->stop('fast');
 
 my $log = $node->logfile();
@@ -54,4 +61,9 @@ like(
 	qr/"Node Type": "Index Scan"[^}]*"Index Name": "pg_class_relname_nsp_index"/s,
 	"index scan logged, json mode");
 
+like(
+	$log_contents,
+	qr/Function Scan on generate_series g\s+\(cost=[^)]*\) \(actual time=[\d.]+\.\.[\d.]+ rows=3333 loops=1\)/,
+	"sampled timing logged, with exact row count");
+
 done_testing();
@@ -55,7 +55,8 @@ CREATE FUNCTION pg_stat_statements(IN showtext boolean,
     OUT jit_optimization_count int8,
     OUT jit_optimization_time float8,
     OUT jit_emission_count int8,
-    OUT jit_emission_time float8
+    OUT jit_emission_time float8,
+    OUT exec_time_histogram int8[]
 )
 RETURNS SETOF record
 AS 'MODULE_PATHNAME', 'pg_stat_statements_1_10'
@@ -19,19 +19,25 @@
  * these strings in a temporary external query-texts file.  Offsets into this
  * file are kept in shared memory.
  *
- * Note about locking issues: to create or delete an entry in the shared
- * hashtable, one must hold pgss->lock exclusively.  Modifying any field
- * in an entry except the counters requires the same.  To look up an entry,
- * one must hold the lock shared.  To read or update the counters within
- * an entry, one must hold the lock shared or exclusive (so the entry doesn't
- * disappear!) and also take the entry's mutex spinlock.
+ * Note about locking issues: the shared hashtable is divided into
+ * PGSS_NUM_PARTITIONS partitions by hash code, each protected by its own
+ * LWLock, so that backends storing statistics for different queries don't
+ * contend with each other.  To create an entry, one must hold its partition
+ * lock exclusively.  To look up an entry, one must hold the partition lock
+ * shared.  To read or update the counters within an entry, one must hold
+ * the partition lock shared or exclusive (so the entry doesn't disappear!)
+ * and also take the entry's mutex spinlock.  Deleting entries, modifying any
+ * field in an entry except the counters, and scanning the whole table all
+ * require holding every partition lock, exclusively or shared as the case
+ * may be; see pgss_lock_all().
  * The shared state variable pgss->extent (the next free spot in the external
  * query-text file) should be accessed only while holding either the
- * pgss->mutex spinlock, or exclusive lock on pgss->lock.  We use the mutex to
- * allow reserving file space while holding only shared lock on pgss->lock.
- * Rewriting the entire external query-text file, eg for garbage collection,
- * requires holding pgss->lock exclusively; this allows individual entries
- * in the file to be read or written while holding only shared lock.
+ * pgss->mutex spinlock, or exclusive lock on all partitions.  We use the
+ * mutex to allow reserving file space while holding only a shared partition
+ * lock.  Rewriting the entire external query-text file, eg for garbage
+ * collection, requires holding all partition locks exclusively; this allows
+ * individual entries in the file to be read or written while holding any
+ * one partition lock shared.
  *
  *
  * Copyright (c) 2008-2022, PostgreSQL Global Development Group
@@ -49,6 +55,7 @@
 
 #include "access/parallel.h"
 #include "catalog/pg_authid.h"
+#include "catalog/pg_type.h"
 #include "common/hashfn.h"
 #include "executor/instrument.h"
 #include "funcapi.h"
@@ -67,7 +74,9 @@
 #include "storage/shmem.h"
 #include "storage/spin.h"
 #include "tcop/utility.h"
+#include "port/pg_bitutils.h"
 #include "utils/acl.h"
+#include "utils/array.h"
 #include "utils/builtins.h"
 #include "utils/queryjumble.h"
 #include "utils/memutils.h"
@@ -84,7 +93,7 @@ PG_MODULE_MAGIC;
 #define PGSS_TEXT_FILE	PG_STAT_TMP_DIR "/pgss_query_texts.stat"
 
 /* Magic number identifying the stats file format */
-static const uint32 PGSS_FILE_HEADER = 0x20220408;
+static const uint32 PGSS_FILE_HEADER = 0x20221017;
 
 /* PostgreSQL major version number, changes in which invalidate all entries */
 static const uint32 PGSS_PG_MAJOR_VERSION = PG_VERSION_NUM / 100;
@@ -97,8 +106,18 @@ static const uint32 PGSS_PG_MAJOR_VERSION = PG_VERSION_NUM / 100;
 #define USAGE_DECREASE_FACTOR	(0.99)	/* decreased every entry_dealloc */
 #define STICKY_DECREASE_FACTOR	(0.50)	/* factor for sticky entries */
 #define USAGE_DEALLOC_PERCENT	5	/* free this % of entries at once */
+#define PGSS_NUM_PARTITIONS		16	/* # of hashtable partitions; must be a
+									 * power of 2 */
 #define IS_STICKY(c)	((c.calls[PGSS_PLAN] + c.calls[PGSS_EXEC]) == 0)
 
+/*
+ * Number of buckets in the execution time histogram.  Bucket 0 counts
+ * executions that took less than 1 microsecond; bucket i > 0 counts those
+ * that took at least 2^(i-1) and less than 2^i microseconds, except that the
+ * last bucket has no upper bound.
+ */
+#define PGSS_EXEC_HIST_BUCKETS	32
+
 /*
  * Utility statements that pgss_ProcessUtility and pgss_post_parse_analyze
  * ignores.
@@ -200,6 +219,8 @@ typedef struct Counters
 	int64		jit_emission_count; /* number of times emission time has been
 									 * > 0 */
 	double		jit_emission_time;	/* total time to emit jit code */
+	int64		exec_time_hist[PGSS_EXEC_HIST_BUCKETS]; /* # of executions by
+														 * execution time */
 } Counters;
 
 /*
@@ -233,7 +254,8 @@ typedef struct pgssEntry
  */
 typedef struct pgssSharedState
 {
-	LWLock	   *lock;			/* protects hashtable search/modification */
+	LWLockPadded *locks;		/* PGSS_NUM_PARTITIONS hashtable partition
+								 * locks */
 	double		cur_median_usage;	/* current median usage in hashtable */
 	Size		mean_query_len; /* current mean entry text length */
 	slock_t		mutex;			/* protects following fields only: */
@@ -294,6 +316,10 @@ static bool pgss_save;			/* whether to save stats across shutdown */
 	(pgss_track == PGSS_TRACK_ALL || \
 	(pgss_track == PGSS_TRACK_TOP && (level) == 0)))
 
+/* Lock protecting the hashtable partition containing the given hash code */
+#define PGSS_PARTITION_LOCK(hashcode) \
+	(&pgss->locks[(hashcode) % PGSS_NUM_PARTITIONS].lock)
+
 #define record_gc_qtexts() \
 	do { \
 		volatile pgssSharedState *s = (volatile pgssSharedState *) pgss; \
@@ -347,8 +373,11 @@ static void pg_stat_statements_internal(FunctionCallInfo fcinfo,
 										pgssVersion api_version,
 										bool showtext);
 static Size pgss_memsize(void);
+static int	pgss_hist_bucket(double total_time);
+static void pgss_lock_all(LWLockMode mode);
+static void pgss_unlock_all(void);
 static pgssEntry *entry_alloc(pgssHashKey *key, Size query_offset, int query_len,
-							  int encoding, bool sticky);
+							  int encoding, bool sticky, bool can_dealloc);
 static void entry_dealloc(void);
 static bool qtext_store(const char *query, int query_len,
 						Size *query_offset, int *gc_count);
@@ -457,7 +486,7 @@ _PG_init(void)
 	 * resources in pgss_shmem_startup().
 	 */
 	RequestAddinShmemSpace(pgss_memsize());
-	RequestNamedLWLockTranche("pg_stat_statements", 1);
+	RequestNamedLWLockTranche("pg_stat_statements", PGSS_NUM_PARTITIONS);
 
 	/*
 	 * Install hooks.
@@ -519,7 +548,7 @@ pgss_shmem_startup(void)
 	if (!found)
 	{
 		/* First time through ... */
-		pgss->lock = &(GetNamedLWLockTranche("pg_stat_statements"))->lock;
+		pgss->locks = GetNamedLWLockTranche("pg_stat_statements");
 		pgss->cur_median_usage = ASSUMED_MEDIAN_INIT;
 		pgss->mean_query_len = ASSUMED_LENGTH_INIT;
 		SpinLockInit(&pgss->mutex);
@@ -532,10 +561,12 @@ pgss_shmem_startup(void)
 
 	info.keysize = sizeof(pgssHashKey);
 	info.entrysize = sizeof(pgssEntry);
+	info.num_partitions = PGSS_NUM_PARTITIONS;
 	pgss_hash = ShmemInitHash("pg_stat_statements hash",
 							  pgss_max, pgss_max,
 							  &info,
-							  HASH_ELEM | HASH_BLOBS);
+							  HASH_ELEM | HASH_BLOBS | HASH_PARTITION |
+							  HASH_FIXED_SIZE);
 
 	LWLockRelease(AddinShmemInitLock);
 
@@ -640,7 +671,7 @@ pgss_shmem_startup(void)
 		/* make the hashtable entry (discards old entries if too many) */
 		entry = entry_alloc(&temp.key, query_offset, temp.query_len,
 							temp.encoding,
-							false);
+							false, true);
 
 		/* copy in the actual stats */
 		entry->counters = temp.counters;
@@ -1209,6 +1240,9 @@ pgss_store(const char *query, uint64 queryId,
 		   JumbleState *jstate)
 {
 	pgssHashKey key;
+	uint32		hashcode;
+	LWLock	   *partitionLock;
+	bool		lock_all = false;
 	pgssEntry  *entry;
 	char	   *norm_query = NULL;
 	int			encoding = GetDatabaseEncoding();
@@ -1243,10 +1277,14 @@ pgss_store(const char *query, uint64 queryId,
 	key.queryid = queryId;
 	key.toplevel = (exec_nested_level == 0);
 
-	/* Lookup the hash table entry with shared lock. */
-	LWLockAcquire(pgss->lock, LW_SHARED);
+	/* Lookup the hash table entry with shared lock on its partition. */
+	hashcode = get_hash_value(pgss_hash, &key);
+	partitionLock = PGSS_PARTITION_LOCK(hashcode);
+	LWLockAcquire(partitionLock, LW_SHARED);
 
-	entry = (pgssEntry *) hash_search(pgss_hash, &key, HASH_FIND, NULL);
+	entry = (pgssEntry *) hash_search_with_hash_value(pgss_hash, &key,
+													  hashcode,
+													  HASH_FIND, NULL);
 
 	/* Create new entry, if not present */
 	if (!entry)
@@ -1265,11 +1303,11 @@ pgss_store(const char *query, uint64 queryId,
 		 */
 		if (jstate)
 		{
-			LWLockRelease(pgss->lock);
+			LWLockRelease(partitionLock);
 			norm_query = generate_normalized_query(jstate, query,
 												   query_location,
 												   &query_len);
-			LWLockAcquire(pgss->lock, LW_SHARED);
+			LWLockAcquire(partitionLock, LW_SHARED);
 		}
 
 		/* Append new query text to file with only shared lock held */
@@ -1283,9 +1321,18 @@ pgss_store(const char *query, uint64 queryId,
 		 */
 		do_gc = need_gc_qtexts();
 
-		/* Need exclusive lock to make a new hashtable entry - promote */
-		LWLockRelease(pgss->lock);
-		LWLockAcquire(pgss->lock, LW_EXCLUSIVE);
+		/*
+		 * Need exclusive lock on the partition to make a new hashtable entry
+		 * - promote.  If the hashtable is full or the query texts need
+		 * garbage collection, we need exclusive lock on all partitions
+		 * instead, which we mustn't wait for while holding any one of them.
+		 */
+		lock_all = do_gc || hash_get_num_entries(pgss_hash) >= pgss_max;
+		LWLockRelease(partitionLock);
+		if (lock_all)
+			pgss_lock_all(LW_EXCLUSIVE);
+		else
+			LWLockAcquire(partitionLock, LW_EXCLUSIVE);
 
 		/*
 		 * A garbage collection may have occurred while we weren't holding the
@@ -1302,9 +1349,15 @@ pgss_store(const char *query, uint64 queryId,
 		if (!stored)
 			goto done;
 
-		/* OK to create a new hashtable entry */
+		/*
+		 * OK to create a new hashtable entry.  Without all the locks, this
+		 * can fail if other backends filled the table in the meantime; just
+		 * forget about this execution in that case.
+		 */
 		entry = entry_alloc(&key, query_offset, query_len, encoding,
-							jstate != NULL);
+							jstate != NULL, lock_all);
+		if (!entry)
+			goto done;
 
 		/* If needed, perform garbage collection while exclusive lock held */
 		if (do_gc)
@@ -1356,6 +1409,8 @@ pgss_store(const char *query, uint64 queryId,
 			if (e->counters.max_time[kind] < total_time)
 				e->counters.max_time[kind] = total_time;
 		}
+		if (kind == PGSS_EXEC)
+			e->counters.exec_time_hist[pgss_hist_bucket(total_time)] += 1;
 		e->counters.rows += rows;
 		e->counters.shared_blks_hit += bufusage->shared_blks_hit;
 		e->counters.shared_blks_read += bufusage->shared_blks_read;
@@ -1397,7 +1452,10 @@ pgss_store(const char *query, uint64 queryId,
 	}
 
 done:
-	LWLockRelease(pgss->lock);
+	if (lock_all)
+		pgss_unlock_all();
+	else
+		LWLockRelease(partitionLock);
 
 	/* We postpone this clean-up until we're out of the lock */
 	if (norm_query)
@@ -1441,8 +1499,8 @@ pg_stat_statements_reset(PG_FUNCTION_ARGS)
 #define PG_STAT_STATEMENTS_COLS_V1_3	23
 #define PG_STAT_STATEMENTS_COLS_V1_8	32
 #define PG_STAT_STATEMENTS_COLS_V1_9	33
-#define PG_STAT_STATEMENTS_COLS_V1_10	43
-#define PG_STAT_STATEMENTS_COLS			43	/* maximum of above */
+#define PG_STAT_STATEMENTS_COLS_V1_10	44
+#define PG_STAT_STATEMENTS_COLS			44	/* maximum of above */
 
 /*
  * Retrieve statement statistics.
@@ -1590,7 +1648,7 @@ pg_stat_statements_internal(FunctionCallInfo fcinfo,
 
 	/*
 	 * We'd like to load the query text file (if needed) while not holding any
-	 * lock on pgss->lock.  In the worst case we'll have to do this again
+	 * of our locks.  In the worst case we'll have to do this again
 	 * after we have the lock, but it's unlikely enough to make this a win
 	 * despite occasional duplicated work.  We need to reload if anybody
 	 * writes to the file (either a retail qtext_store(), or a garbage
@@ -1619,17 +1677,15 @@ pg_stat_statements_internal(FunctionCallInfo fcinfo,
 	}
 
 	/*
-	 * Get shared lock, load or reload the query text file if we must, and
+	 * Get shared locks, load or reload the query text file if we must, and
 	 * iterate over the hashtable entries.
 	 *
-	 * With a large hash table, we might be holding the lock rather longer
+	 * With a large hash table, we might be holding the locks rather longer
 	 * than one could wish.  However, this only blocks creation of new hash
 	 * table entries, and the larger the hash table the less likely that is to
-	 * be needed.  So we can hope this is okay.  Perhaps someday we'll decide
-	 * we need to partition the hash table to limit the time spent holding any
-	 * one lock.
+	 * be needed.  So we can hope this is okay.
 	 */
-	LWLockAcquire(pgss->lock, LW_SHARED);
+	pgss_lock_all(LW_SHARED);
 
 	if (showtext)
 	{
@@ -1817,6 +1873,20 @@ pg_stat_statements_internal(FunctionCallInfo fcinfo,
 			values[i++] = Int64GetDatumFast(tmp.jit_emission_count);
 			values[i++] = Float8GetDatumFast(tmp.jit_emission_time);
 		}
+		if (api_version >= PGSS_V1_10)
+		{
+			Datum		hist[PGSS_EXEC_HIST_BUCKETS];
+			int			b;
+
+			for (b = 0; b < PGSS_EXEC_HIST_BUCKETS; b++)
+				hist[b] = Int64GetDatum(tmp.exec_time_hist[b]);
+			values[i++] = PointerGetDatum(construct_array(hist,
+														  PGSS_EXEC_HIST_BUCKETS,
+														  INT8OID,
+														  sizeof(int64),
+														  FLOAT8PASSBYVAL,
+														  TYPALIGN_DOUBLE));
+		}
 
 		Assert(i == (api_version == PGSS_V1_0 ? PG_STAT_STATEMENTS_COLS_V1_0 :
 					 api_version == PGSS_V1_1 ? PG_STAT_STATEMENTS_COLS_V1_1 :
@@ -1830,7 +1900,7 @@ pg_stat_statements_internal(FunctionCallInfo fcinfo,
 		tuplestore_putvalues(rsinfo->setResult, rsinfo->setDesc, values, nulls);
 	}
 
-	LWLockRelease(pgss->lock);
+	pgss_unlock_all();
 
 	if (qbuffer)
 		free(qbuffer);
@@ -1891,9 +1961,49 @@ pgss_memsize(void)
 	return size;
 }
 
+/*
+ * Find the execution time histogram bucket for a time given in msec.
+ */
+static int
+pgss_hist_bucket(double total_time)
+{
+	double		usec = total_time * 1000.0;
+
+	if (usec < 1.0)
+		return 0;
+	if (usec >= (double) (UINT64CONST(1) << (PGSS_EXEC_HIST_BUCKETS - 2)))
+		return PGSS_EXEC_HIST_BUCKETS - 1;
+	return pg_leftmost_one_pos64((uint64) usec) + 1;
+}
+
+/*
+ * Acquire all hashtable partition locks in the given mode, in order.
+ */
+static void
+pgss_lock_all(LWLockMode mode)
+{
+	int			i;
+
+	for (i = 0; i < PGSS_NUM_PARTITIONS; i++)
+		LWLockAcquire(&pgss->locks[i].lock, mode);
+}
+
+/*
+ * Release all hashtable partition locks.
+ */
+static void
+pgss_unlock_all(void)
+{
+	int			i;
+
+	for (i = PGSS_NUM_PARTITIONS; --i >= 0;)
+		LWLockRelease(&pgss->locks[i].lock);
+}
+
 /*
  * Allocate a new hashtable entry.
- * caller must hold an exclusive lock on pgss->lock
+ * caller must hold an exclusive lock on the entry's partition, and if
+ * can_dealloc is true, on all partitions
  *
  * "query" need not be null-terminated; we rely on query_len instead
  *
@@ -1903,6 +2013,10 @@ pgss_memsize(void)
  * speaking, query strings are normalized on a best effort basis, though it
  * would be difficult to demonstrate this even under artificial conditions.)
  *
+ * If can_dealloc is true, least-used entries are deallocated to make room
+ * if the table is full.  Otherwise we just try to insert, and return NULL
+ * if there's no room.
+ *
  * Note: despite needing exclusive lock, it's not an error for the target
  * entry to already exist.  This is because pgss_store releases and
  * reacquires lock after failing to find a match; so someone else could
@@ -1910,17 +2024,21 @@ pgss_memsize(void)
  */
 static pgssEntry *
 entry_alloc(pgssHashKey *key, Size query_offset, int query_len, int encoding,
-			bool sticky)
+			bool sticky, bool can_dealloc)
 {
 	pgssEntry  *entry;
 	bool		found;
 
 	/* Make space if needed */
-	while (hash_get_num_entries(pgss_hash) >= pgss_max)
+	while (can_dealloc && hash_get_num_entries(pgss_hash) >= pgss_max)
 		entry_dealloc();
 
 	/* Find or create an entry with desired hash code */
-	entry = (pgssEntry *) hash_search(pgss_hash, key, HASH_ENTER, &found);
+	entry = (pgssEntry *) hash_search(pgss_hash, key,
+									  can_dealloc ? HASH_ENTER : HASH_ENTER_NULL,
+									  &found);
+	if (!entry)
+		return NULL;
 
 	if (!found)
 	{
@@ -1962,7 +2080,7 @@ entry_cmp(const void *lhs, const void *rhs)
 /*
  * Deallocate least-used entries.
  *
- * Caller must hold an exclusive lock on pgss->lock.
+ * Caller must hold exclusive locks on all hashtable partitions.
  */
 static void
 entry_dealloc(void)
@@ -2053,11 +2171,12 @@ entry_dealloc(void)
  *
  * On failure, returns false.
  *
- * At least a shared lock on pgss->lock must be held by the caller, so as
- * to prevent a concurrent garbage collection.  Share-lock-holding callers
- * should pass a gc_count pointer to obtain the number of garbage collections,
- * so that they can recheck the count after obtaining exclusive lock to
- * detect whether a garbage collection occurred (and removed this entry).
+ * At least a shared lock on one hashtable partition must be held by the
+ * caller, so as to prevent a concurrent garbage collection.  Share-lock-
+ * holding callers should pass a gc_count pointer to obtain the number of
+ * garbage collections, so that they can recheck the count after obtaining
+ * exclusive lock to detect whether a garbage collection occurred (and
+ * removed this entry).
  */
 static bool
 qtext_store(const char *query, int query_len,
@@ -2136,7 +2255,7 @@ error:
  *
  * On success, the buffer size is also returned into *buffer_size.
  *
- * This can be called without any lock on pgss->lock, but in that case
+ * This can be called without any partition lock, but in that case
  * the caller is responsible for verifying that the result is sane.
  */
 static char *
@@ -2253,7 +2372,7 @@ qtext_fetch(Size query_offset, int query_len,
 /*
  * Do we need to garbage-collect the external query text file?
  *
- * Caller should hold at least a shared lock on pgss->lock.
+ * Caller should hold at least a shared lock on one hashtable partition.
  */
 static bool
 need_gc_qtexts(void)
@@ -2296,7 +2415,7 @@ need_gc_qtexts(void)
  * becomes unreasonably large, with no other method of compaction likely to
  * occur in the foreseeable future.
  *
- * The caller must hold an exclusive lock on pgss->lock.
+ * The caller must hold exclusive locks on all hashtable partitions.
  *
  * At the first sign of trouble we unlink the query text file to get a clean
  * slate (although existing statistics are retained), rather than risk
@@ -2423,10 +2542,10 @@ gc_qtexts(void)
 
 	/*
 	 * OK, count a garbage collection cycle.  (Note: even though we have
-	 * exclusive lock on pgss->lock, we must take pgss->mutex for this, since
-	 * other processes may examine gc_count while holding only the mutex.
-	 * Also, we have to advance the count *after* we've rewritten the file,
-	 * else other processes might not realize they read a stale file.)
+	 * exclusive lock on all partitions, we must take pgss->mutex for this,
+	 * since other processes may examine gc_count while holding only the
+	 * mutex.  Also, we have to advance the count *after* we've rewritten the
+	 * file, else other processes might not realize they read a stale file.)
 	 */
 	record_gc_qtexts();
 
@@ -2472,13 +2591,14 @@ gc_fail:
 	/*
 	 * Bump the GC count even though we failed.
 	 *
-	 * This is needed to make concurrent readers of file without any lock on
-	 * pgss->lock notice existence of new version of file.  Once readers
-	 * subsequently observe a change in GC count with pgss->lock held, that
-	 * forces a safe reopen of file.  Writers also require that we bump here,
-	 * of course.  (As required by locking protocol, readers and writers don't
-	 * trust earlier file contents until gc_count is found unchanged after
-	 * pgss->lock acquired in shared or exclusive mode respectively.)
+	 * This is needed to make concurrent readers of file without any partition
+	 * lock notice existence of new version of file.  Once readers
+	 * subsequently observe a change in GC count with partition locks held,
+	 * that forces a safe reopen of file.  Writers also require that we bump
+	 * here, of course.  (As required by locking protocol, readers and writers
+	 * don't trust earlier file contents until gc_count is found unchanged
+	 * after partition locks are acquired in shared or exclusive mode
+	 * respectively.)
 	 */
 	record_gc_qtexts();
 }
@@ -2501,7 +2621,7 @@ entry_reset(Oid userid, Oid dbid, uint64 queryid)
 				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
 				 errmsg("pg_stat_statements must be loaded via shared_preload_libraries")));
 
-	LWLockAcquire(pgss->lock, LW_EXCLUSIVE);
+	pgss_lock_all(LW_EXCLUSIVE);
 	num_entries = hash_get_num_entries(pgss_hash);
 
 	if (userid != 0 && dbid != 0 && queryid != UINT64CONST(0))
@@ -2599,7 +2719,7 @@ done:
 	record_gc_qtexts();
 
 release_lock:
-	LWLockRelease(pgss->lock);
+	pgss_unlock_all();
 }
 
 /*
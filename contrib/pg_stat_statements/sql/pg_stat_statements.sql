@@ -442,4 +442,12 @@ SELECT (
 
 SELECT COUNT(*) FROM pg_stat_statements WHERE query LIKE '%SELECT GROUPING%';
 
+--
+-- execution time histograms account for every execution
+--
+SELECT bool_and(cardinality(exec_time_histogram) = 32) AS hist_size_ok,
+       bool_and(calls = (SELECT sum(h) FROM unnest(exec_time_histogram) h))
+         AS hist_sum_ok
+  FROM pg_stat_statements;
+
 DROP EXTENSION pg_stat_statements;
@@ -170,6 +170,30 @@ commit;
 select * from pg_visibility_map('copyfreeze');
 select * from pg_check_frozen('copyfreeze');
 
+-- vacuum_eager_freeze_wal_age: at 0, every page VACUUM sets all-visible is
+-- old enough to be frozen as a whole, even though no tuple on it is older
+-- than vacuum_freeze_min_age.
+create table eagerfreeze (a int) with (autovacuum_enabled = off);
+insert into eagerfreeze select generate_series(1, 500);
+vacuum eagerfreeze;
+select * from pg_visibility_map('eagerfreeze');
+set vacuum_eager_freeze_wal_age = 0;
+vacuum eagerfreeze;
+select * from pg_visibility_map('eagerfreeze');
+select * from pg_check_frozen('eagerfreeze');
+
+-- A page with a MultiXactId xmax is not frozen eagerly.
+create table eagerfreeze_multi (a int) with (autovacuum_enabled = off);
+insert into eagerfreeze_multi select generate_series(1, 10);
+begin;
+select * from eagerfreeze_multi where a = 1 for share;
+savepoint s;
+select * from eagerfreeze_multi where a = 1 for update;
+commit;
+vacuum eagerfreeze_multi;
+select * from pg_visibility_map('eagerfreeze_multi');
+reset vacuum_eager_freeze_wal_age;
+
 -- cleanup
 drop table test_partitioned;
 drop view test_view;
@@ -180,3 +204,5 @@ drop foreign data wrapper dummy;
 drop materialized view matview_visibility_test;
 drop table regular_table;
 drop table copyfreeze;
+drop table eagerfreeze;
+drop table eagerfreeze_multi;
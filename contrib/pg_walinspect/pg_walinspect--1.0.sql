@@ -116,3 +116,40 @@ LANGUAGE C STRICT PARALLEL SAFE;
 
 REVOKE EXECUTE ON FUNCTION pg_get_wal_stats_till_end_of_wal(pg_lsn, boolean) FROM PUBLIC;
 GRANT EXECUTE ON FUNCTION pg_get_wal_stats_till_end_of_wal(pg_lsn, boolean) TO pg_read_server_files;
+
+--
+-- pg_get_wal_block_changes()
+--
+CREATE FUNCTION pg_get_wal_block_changes(IN start_lsn pg_lsn,
+    IN end_lsn pg_lsn,
+    OUT reltablespace oid,
+    OUT reldatabase oid,
+    OUT relfilenode oid,
+    OUT relforknumber int2,
+    OUT relblocknumber int8,
+    OUT last_lsn pg_lsn
+)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME', 'pg_get_wal_block_changes'
+LANGUAGE C STRICT PARALLEL SAFE;
+
+REVOKE EXECUTE ON FUNCTION pg_get_wal_block_changes(pg_lsn, pg_lsn) FROM PUBLIC;
+GRANT EXECUTE ON FUNCTION pg_get_wal_block_changes(pg_lsn, pg_lsn) TO pg_read_server_files;
+
+--
+-- pg_get_wal_block_changes_till_end_of_wal()
+--
+CREATE FUNCTION pg_get_wal_block_changes_till_end_of_wal(IN start_lsn pg_lsn,
+    OUT reltablespace oid,
+    OUT reldatabase oid,
+    OUT relfilenode oid,
+    OUT relforknumber int2,
+    OUT relblocknumber int8,
+    OUT last_lsn pg_lsn
+)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME', 'pg_get_wal_block_changes_till_end_of_wal'
+LANGUAGE C STRICT PARALLEL SAFE;
+
+REVOKE EXECUTE ON FUNCTION pg_get_wal_block_changes_till_end_of_wal(pg_lsn) FROM PUBLIC;
+GRANT EXECUTE ON FUNCTION pg_get_wal_block_changes_till_end_of_wal(pg_lsn) TO pg_read_server_files;
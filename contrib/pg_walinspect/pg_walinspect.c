@@ -20,7 +20,9 @@
 #include "access/xlogutils.h"
 #include "funcapi.h"
 #include "miscadmin.h"
+#include "storage/relfilenode.h"
 #include "utils/builtins.h"
+#include "utils/hsearch.h"
 #include "utils/pg_lsn.h"
 
 /*
@@ -35,6 +37,24 @@ PG_FUNCTION_INFO_V1(pg_get_wal_records_info);
 PG_FUNCTION_INFO_V1(pg_get_wal_records_info_till_end_of_wal);
 PG_FUNCTION_INFO_V1(pg_get_wal_stats);
 PG_FUNCTION_INFO_V1(pg_get_wal_stats_till_end_of_wal);
+PG_FUNCTION_INFO_V1(pg_get_wal_block_changes);
+PG_FUNCTION_INFO_V1(pg_get_wal_block_changes_till_end_of_wal);
+
+/*
+ * A block modified by WAL records, and the end LSN of the last of them.
+ */
+typedef struct BlockChangeKey
+{
+	RelFileNode rnode;
+	ForkNumber	forknum;
+	BlockNumber blkno;
+} BlockChangeKey;
+
+typedef struct BlockChangeEntry
+{
+	BlockChangeKey key;			/* hash key; must be first */
+	XLogRecPtr	last_lsn;
+} BlockChangeEntry;
 
 static bool IsFutureLSN(XLogRecPtr lsn, XLogRecPtr *curr_lsn);
 static XLogReaderState *InitXLogReaderState(XLogRecPtr lsn,
@@ -57,6 +77,9 @@ static void FillXLogStatsRow(const char *name, uint64 n, uint64 total_count,
 							 Datum *values, bool *nulls, uint32 ncols);
 static void GetWalStats(FunctionCallInfo fcinfo, XLogRecPtr start_lsn,
 						XLogRecPtr end_lsn, bool stats_per_record);
+static int	block_change_cmp(const void *a, const void *b);
+static void GetWALBlockChanges(FunctionCallInfo fcinfo, XLogRecPtr start_lsn,
+							   XLogRecPtr end_lsn);
 
 /*
  * Check if the given LSN is in future. Also, return the LSN up to which the
@@ -634,3 +657,173 @@ pg_get_wal_stats_till_end_of_wal(PG_FUNCTION_ARGS)
 
 	PG_RETURN_VOID();
 }
+
+/*
+ * qsort comparator for BlockChangeEntry, in physical file order.
+ */
+static int
+block_change_cmp(const void *a, const void *b)
+{
+	const BlockChangeKey *ka = &((const BlockChangeEntry *) a)->key;
+	const BlockChangeKey *kb = &((const BlockChangeEntry *) b)->key;
+
+	if (ka->rnode.spcNode != kb->rnode.spcNode)
+		return ka->rnode.spcNode < kb->rnode.spcNode ? -1 : 1;
+	if (ka->rnode.dbNode != kb->rnode.dbNode)
+		return ka->rnode.dbNode < kb->rnode.dbNode ? -1 : 1;
+	if (ka->rnode.relNode != kb->rnode.relNode)
+		return ka->rnode.relNode < kb->rnode.relNode ? -1 : 1;
+	if (ka->forknum != kb->forknum)
+		return ka->forknum < kb->forknum ? -1 : 1;
+	if (ka->blkno != kb->blkno)
+		return ka->blkno < kb->blkno ? -1 : 1;
+	return 0;
+}
+
+/*
+ * Get the distinct blocks modified by WAL records between start LSN and end
+ * LSN, sorted by relation file, fork and block number.
+ *
+ * This is the information needed to take an incremental copy of the data
+ * directory, but only as far as WAL-logged changes go: every block referenced
+ * by a record may have changed, but blocks can also change without being
+ * referenced.  Unlogged relations are never WAL-logged, and with wal_level =
+ * minimal, a relation created or rewritten in a transaction may be synced to
+ * disk at commit instead.  Hint bit updates aren't WAL-logged either unless
+ * checksums or wal_log_hints are enabled.  Relation files created, dropped
+ * or truncated in the range have to be detected separately, by comparing
+ * file sizes or lists.
+ */
+static void
+GetWALBlockChanges(FunctionCallInfo fcinfo, XLogRecPtr start_lsn,
+				   XLogRecPtr end_lsn)
+{
+#define PG_GET_WAL_BLOCK_CHANGES_COLS 6
+	XLogRecPtr	first_record;
+	XLogReaderState *xlogreader;
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	Datum		values[PG_GET_WAL_BLOCK_CHANGES_COLS];
+	bool		nulls[PG_GET_WAL_BLOCK_CHANGES_COLS];
+	HASHCTL		hash_ctl;
+	HTAB	   *changes;
+	HASH_SEQ_STATUS status;
+	BlockChangeEntry *entry;
+	BlockChangeEntry *sorted;
+	long		nchanges;
+	long		i;
+
+	SetSingleFuncCall(fcinfo, 0);
+
+	hash_ctl.keysize = sizeof(BlockChangeKey);
+	hash_ctl.entrysize = sizeof(BlockChangeEntry);
+	hash_ctl.hcxt = CurrentMemoryContext;
+	changes = hash_create("pg_walinspect block changes", 1024, &hash_ctl,
+						  HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+
+	xlogreader = InitXLogReaderState(start_lsn, &first_record);
+
+	while (ReadNextXLogRecord(xlogreader, first_record) &&
+		   xlogreader->EndRecPtr <= end_lsn)
+	{
+		for (int block_id = 0; block_id <= XLogRecMaxBlockId(xlogreader);
+			 block_id++)
+		{
+			BlockChangeKey key;
+			bool		found;
+
+			/* zero the padding, since the key is hashed as a blob */
+			MemSet(&key, 0, sizeof(key));
+
+			if (!XLogRecGetBlockTagExtended(xlogreader, block_id, &key.rnode,
+											&key.forknum, &key.blkno, NULL))
+				continue;
+
+			entry = (BlockChangeEntry *) hash_search(changes, &key,
+													 HASH_ENTER, &found);
+			entry->last_lsn = xlogreader->EndRecPtr;
+		}
+
+		CHECK_FOR_INTERRUPTS();
+	}
+
+	pfree(xlogreader->private_data);
+	XLogReaderFree(xlogreader);
+
+	/* Emit the blocks in physical order, which is what copying wants. */
+	nchanges = hash_get_num_entries(changes);
+	sorted = (BlockChangeEntry *)
+		palloc_extended(Max(nchanges, 1) * sizeof(BlockChangeEntry),
+						MCXT_ALLOC_HUGE);
+
+	i = 0;
+	hash_seq_init(&status, changes);
+	while ((entry = (BlockChangeEntry *) hash_seq_search(&status)) != NULL)
+		sorted[i++] = *entry;
+	hash_destroy(changes);
+
+	qsort(sorted, nchanges, sizeof(BlockChangeEntry), block_change_cmp);
+
+	MemSet(nulls, 0, sizeof(nulls));
+
+	for (i = 0; i < nchanges; i++)
+	{
+		BlockChangeKey *key = &sorted[i].key;
+
+		values[0] = ObjectIdGetDatum(key->rnode.spcNode);
+		values[1] = ObjectIdGetDatum(key->rnode.dbNode);
+		values[2] = ObjectIdGetDatum(key->rnode.relNode);
+		values[3] = Int16GetDatum(key->forknum);
+		values[4] = Int64GetDatum((int64) key->blkno);
+		values[5] = LSNGetDatum(sorted[i].last_lsn);
+
+		tuplestore_putvalues(rsinfo->setResult, rsinfo->setDesc,
+							 values, nulls);
+	}
+
+	pfree(sorted);
+
+#undef PG_GET_WAL_BLOCK_CHANGES_COLS
+}
+
+/*
+ * Get the blocks modified by WAL records between start LSN and end LSN.
+ *
+ * This function emits an error if a future start or end WAL LSN i.e. WAL LSN
+ * the database system doesn't know about is specified.
+ */
+Datum
+pg_get_wal_block_changes(PG_FUNCTION_ARGS)
+{
+	XLogRecPtr	start_lsn;
+	XLogRecPtr	end_lsn;
+
+	start_lsn = PG_GETARG_LSN(0);
+	end_lsn = PG_GETARG_LSN(1);
+
+	end_lsn = ValidateInputLSNs(false, start_lsn, end_lsn);
+
+	GetWALBlockChanges(fcinfo, start_lsn, end_lsn);
+
+	PG_RETURN_VOID();
+}
+
+/*
+ * Get the blocks modified by WAL records from start LSN till end of WAL.
+ *
+ * This function emits an error if a future start i.e. WAL LSN the database
+ * system doesn't know about is specified.
+ */
+Datum
+pg_get_wal_block_changes_till_end_of_wal(PG_FUNCTION_ARGS)
+{
+	XLogRecPtr	start_lsn;
+	XLogRecPtr	end_lsn = InvalidXLogRecPtr;
+
+	start_lsn = PG_GETARG_LSN(0);
+
+	end_lsn = ValidateInputLSNs(true, start_lsn, end_lsn);
+
+	GetWALBlockChanges(fcinfo, start_lsn, end_lsn);
+
+	PG_RETURN_VOID();
+}
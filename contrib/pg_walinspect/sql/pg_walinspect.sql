@@ -21,6 +21,8 @@ SELECT COUNT(*) >= 0 AS ok FROM pg_get_wal_records_info(:'wal_lsn2', :'wal_lsn1'
 
 SELECT COUNT(*) >= 0 AS ok FROM pg_get_wal_stats(:'wal_lsn2', :'wal_lsn1'); -- ERROR
 
+SELECT COUNT(*) >= 0 AS ok FROM pg_get_wal_block_changes(:'wal_lsn2', :'wal_lsn1'); -- ERROR
+
 -- ===================================================================
 -- Tests for all function executions
 -- ===================================================================
@@ -35,6 +37,10 @@ SELECT COUNT(*) >= 0 AS ok FROM pg_get_wal_stats(:'wal_lsn1', :'wal_lsn2');
 
 SELECT COUNT(*) >= 0 AS ok FROM pg_get_wal_stats_till_end_of_wal(:'wal_lsn1');
 
+SELECT COUNT(*) >= 0 AS ok FROM pg_get_wal_block_changes(:'wal_lsn1', :'wal_lsn2');
+
+SELECT COUNT(*) >= 0 AS ok FROM pg_get_wal_block_changes_till_end_of_wal(:'wal_lsn1');
+
 -- ===================================================================
 -- Test for filtering out WAL records of a particular table
 -- ===================================================================
@@ -44,6 +50,9 @@ SELECT oid AS sample_tbl_oid FROM pg_class WHERE relname = 'sample_tbl' \gset
 SELECT COUNT(*) >= 1 AS ok FROM pg_get_wal_records_info(:'wal_lsn1', :'wal_lsn2')
 			WHERE block_ref LIKE concat('%', :'sample_tbl_oid', '%') AND resource_manager = 'Heap';
 
+SELECT COUNT(*) >= 1 AS ok FROM pg_get_wal_block_changes(:'wal_lsn1', :'wal_lsn2')
+			WHERE relfilenode = pg_relation_filenode('sample_tbl') AND relforknumber = 0;
+
 -- ===================================================================
 -- Test for filtering out WAL records based on resource_manager and
 -- record_type
@@ -33,6 +33,7 @@
 #include "postmaster/autovacuum.h"
 #include "storage/bufmgr.h"
 #include "storage/freespace.h"
+#include "storage/lmgr.h"
 #include "utils/acl.h"
 #include "utils/builtins.h"
 #include "utils/datum.h"
@@ -74,6 +75,8 @@ static BrinBuildState *initialize_brin_buildstate(Relation idxRel,
 static void terminate_brin_buildstate(BrinBuildState *state);
 static void brinsummarize(Relation index, Relation heapRel, BlockNumber pageRange,
 						  bool include_partial, double *numSummarized, double *numExisting);
+static bool brin_summarize_new_range(Relation idxRel, Relation heapRel,
+									 BlockNumber heapBlk);
 static void form_and_insert_tuple(BrinBuildState *state);
 static void union_tuples(BrinDesc *bdesc, BrinMemTuple *a,
 						 BrinTuple *b);
@@ -146,7 +149,8 @@ brinhandler(PG_FUNCTION_ARGS)
  * the summary tuple, we need to update the index tuple.
  *
  * If autosummarization is enabled, check if we need to summarize the previous
- * page range.
+ * page range, and summarize a page range that this insertion just opened at
+ * the end of the table.
  *
  * If the range is not currently summarized (i.e. the revmap returns NULL for
  * it), there's nothing to do for this tuple.
@@ -167,6 +171,7 @@ brininsert(Relation idxRel, Datum *values, bool *nulls,
 	MemoryContext tupcxt = NULL;
 	MemoryContext oldcxt = CurrentMemoryContext;
 	bool		autosummarize = BrinGetAutoSummarize(idxRel);
+	bool		tried_summarize = false;
 
 	revmap = brinRevmapInitialize(idxRel, &pagesPerRange, NULL);
 
@@ -191,7 +196,7 @@ brininsert(Relation idxRel, Datum *values, bool *nulls,
 		 * tuple into the first block of a new non-first page range, request a
 		 * summarization run of the previous range.
 		 */
-		if (autosummarize &&
+		if (autosummarize && !tried_summarize &&
 			heapBlk > 0 &&
 			heapBlk == origHeapBlk &&
 			ItemPointerGetOffsetNumber(heaptid) == FirstOffsetNumber)
@@ -223,6 +228,23 @@ brininsert(Relation idxRel, Datum *values, bool *nulls,
 		brtup = brinGetTupleForHeapBlock(revmap, heapBlk, &buf, &off,
 										 NULL, BUFFER_LOCK_SHARE, NULL);
 
+		/*
+		 * If auto-summarization is enabled and we just inserted the first
+		 * tuple into a new page range at the end of the table, summarize that
+		 * range right away.  This is cheap, as the range only has the one page
+		 * so far, and from now on the summary will be kept up to date as the
+		 * range fills, rather than the range staying unsummarized (and being
+		 * returned by every scan) until it's complete.
+		 */
+		if (!brtup && autosummarize && !tried_summarize &&
+			heapBlk == origHeapBlk &&
+			ItemPointerGetOffsetNumber(heaptid) == FirstOffsetNumber)
+		{
+			tried_summarize = true;
+			if (brin_summarize_new_range(idxRel, heapRel, heapBlk))
+				continue;
+		}
+
 		/* if range is unsummarized, there's nothing to do */
 		if (!brtup)
 			break;
@@ -1554,6 +1576,37 @@ brinsummarize(Relation index, Relation heapRel, BlockNumber pageRange,
 	}
 }
 
+/*
+ * Summarize the page range beginning at heapBlk, on behalf of brininsert,
+ * if it is the last range of the table and has only just been started.
+ *
+ * Summarization runs must not overlap; VACUUM and the SQL-callable functions
+ * hold ShareUpdateExclusiveLock on the table to ensure that.  We take that
+ * lock too, but only if it's immediately available: the insertion shouldn't
+ * wait, and the range will be summarized later in any case.
+ *
+ * Returns true if the range was summarized.
+ */
+static bool
+brin_summarize_new_range(Relation idxRel, Relation heapRel,
+						 BlockNumber heapBlk)
+{
+	double		numSummarized = 0;
+
+	/* A range that's more than one page long is too expensive to do here */
+	if (RelationGetNumberOfBlocks(heapRel) != heapBlk + 1)
+		return false;
+
+	if (!ConditionalLockRelation(heapRel, ShareUpdateExclusiveLock))
+		return false;
+
+	brinsummarize(idxRel, heapRel, heapBlk, true, &numSummarized, NULL);
+
+	UnlockRelation(heapRel, ShareUpdateExclusiveLock);
+
+	return numSummarized > 0;
+}
+
 /*
  * Given a deformed tuple in the build state, convert it into the on-disk
  * format and insert it into the index, making the revmap point to it.
@@ -208,6 +208,32 @@ makeSublist(Relation index, IndexTuple *tuples, int32 ntuples,
 	res->nPendingHeapTuples = 1;
 }
 
+/*
+ * Ask autovacuum to clean up the pending list of a GIN index, instead of
+ * having the inserting backend do it.
+ *
+ * Returns false if the cleanup can't be left to autovacuum: it isn't
+ * running or has been disabled for the table, the index is temporary, or
+ * the work item queue is full.  The caller should clean up the list itself
+ * in that case.  AutoVacuumRequestWork ignores a request for an index that
+ * already has one queued, and checks for that without an exclusive lock, so
+ * the inserts that follow until autovacuum gets to the index stay cheap.
+ */
+static bool
+ginDeferPendingCleanup(Relation index, Relation heapRel)
+{
+	StdRdOptions *heapopts = (StdRdOptions *) heapRel->rd_options;
+
+	if (!AutoVacuumingActive() || IsAutoVacuumWorkerProcess() ||
+		RelationUsesLocalBuffers(index))
+		return false;
+	if (heapopts && !heapopts->autovacuum.enabled)
+		return false;
+
+	return AutoVacuumRequestWork(AVW_GinCleanPendingList,
+								 RelationGetRelid(index), InvalidBlockNumber);
+}
+
 /*
  * Write the index tuples contained in *collector into the index's
  * pending list.
@@ -216,7 +242,8 @@ makeSublist(Relation index, IndexTuple *tuples, int32 ntuples,
  * preserving order
  */
 void
-ginHeapTupleFastInsert(GinState *ginstate, GinTupleCollector *collector)
+ginHeapTupleFastInsert(GinState *ginstate, GinTupleCollector *collector,
+					   Relation heapRel)
 {
 	Relation	index = ginstate->index;
 	Buffer		metabuffer;
@@ -227,6 +254,7 @@ ginHeapTupleFastInsert(GinState *ginstate, GinTupleCollector *collector)
 	ginxlogUpdateMeta data;
 	bool		separateList = false;
 	bool		needCleanup = false;
+	bool		mustCleanup = false;
 	int			cleanupSize;
 	bool		needWal;
 
@@ -444,11 +472,20 @@ ginHeapTupleFastInsert(GinState *ginstate, GinTupleCollector *collector)
 	 * while pending list is still small enough to fit into
 	 * gin_pending_list_limit.
 	 *
+	 * Where possible, leave the cleanup to autovacuum so that this insert
+	 * doesn't pay for it.  If the list keeps growing to twice the limit
+	 * meanwhile, though, clean it up here after all, so that searches don't
+	 * degrade without bound.
+	 *
 	 * ginInsertCleanup() should not be called inside our CRIT_SECTION.
 	 */
 	cleanupSize = GinGetPendingListCleanupSize(index);
 	if (metadata->nPendingPages * GIN_PAGE_FREESIZE > cleanupSize * 1024L)
+	{
 		needCleanup = true;
+		if (metadata->nPendingPages * GIN_PAGE_FREESIZE > cleanupSize * 2048L)
+			mustCleanup = true;
+	}
 
 	UnlockReleaseBuffer(metabuffer);
 
@@ -458,7 +495,8 @@ ginHeapTupleFastInsert(GinState *ginstate, GinTupleCollector *collector)
 	 * Since it could contend with concurrent cleanup process we cleanup
 	 * pending list not forcibly.
 	 */
-	if (needCleanup)
+	if (needCleanup &&
+		(mustCleanup || !ginDeferPendingCleanup(index, heapRel)))
 		ginInsertCleanup(ginstate, false, true, false, NULL);
 }
 
@@ -106,6 +106,60 @@ hashhandler(PG_FUNCTION_ARGS)
 	PG_RETURN_POINTER(amroutine);
 }
 
+/*
+ * hash_sort_threshold() -- number of initial buckets above which a new hash
+ * index is built by sorting its tuples
+ *
+ * If we just insert the tuples into the index in scan order, then (assuming
+ * their hash codes are pretty random) there will be no locality of access to
+ * the index, and if the index is bigger than available RAM then we'll thrash
+ * horribly.  To prevent that scenario, we can sort the tuples by (expected)
+ * bucket number.  However, such a sort is useless overhead when the index
+ * does fit in RAM.  We choose to sort if the initial index size exceeds
+ * maintenance_work_mem, or the number of buffers usable for the index,
+ * whichever is less.  (Limiting by the number of buffers should reduce
+ * thrashing between PG buffers and kernel buffers, which seems useful even if
+ * no physical I/O results.  Limiting by maintenance_work_mem is useful to
+ * allow easy testing of the sort code path, and may be useful to DBAs as an
+ * additional control knob.)
+ *
+ * NOTE: this test will need adjustment if a bucket is ever different from
+ * one page.  Also, "initial index size" accounting does not include the
+ * metapage, nor the first bitmap page.
+ */
+static uint32
+hash_sort_threshold(Relation index)
+{
+	long		sort_threshold;
+
+	sort_threshold = (maintenance_work_mem * 1024L) / BLCKSZ;
+	if (index->rd_rel->relpersistence != RELPERSISTENCE_TEMP)
+		sort_threshold = Min(sort_threshold, NBuffers);
+	else
+		sort_threshold = Min(sort_threshold, NLocBuffer);
+
+	return (uint32) sort_threshold;
+}
+
+/*
+ *	hashbuildsorts() -- will hashbuild() sort the tuples of a new index?
+ *
+ * Only sorted builds are performed in parallel, so index_build() checks this
+ * before planning parallel workers for a hash index.
+ */
+bool
+hashbuildsorts(Relation heap, Relation index)
+{
+	BlockNumber relpages;
+	double		reltuples;
+	double		allvisfrac;
+
+	estimate_rel_size(heap, NULL, &relpages, &reltuples, &allvisfrac);
+
+	return _hash_estimate_buckets(index, reltuples) >=
+		hash_sort_threshold(index);
+}
+
 /*
  *	hashbuild() -- build a new hash index.
  */
@@ -117,7 +171,6 @@ hashbuild(Relation heap, Relation index, IndexInfo *indexInfo)
 	double		reltuples;
 	double		allvisfrac;
 	uint32		num_buckets;
-	long		sort_threshold;
 	HashBuildState buildstate;
 
 	/*
@@ -134,32 +187,8 @@ hashbuild(Relation heap, Relation index, IndexInfo *indexInfo)
 	/* Initialize the hash index metadata page and initial buckets */
 	num_buckets = _hash_init(index, reltuples, MAIN_FORKNUM);
 
-	/*
-	 * If we just insert the tuples into the index in scan order, then
-	 * (assuming their hash codes are pretty random) there will be no locality
-	 * of access to the index, and if the index is bigger than available RAM
-	 * then we'll thrash horribly.  To prevent that scenario, we can sort the
-	 * tuples by (expected) bucket number.  However, such a sort is useless
-	 * overhead when the index does fit in RAM.  We choose to sort if the
-	 * initial index size exceeds maintenance_work_mem, or the number of
-	 * buffers usable for the index, whichever is less.  (Limiting by the
-	 * number of buffers should reduce thrashing between PG buffers and kernel
-	 * buffers, which seems useful even if no physical I/O results.  Limiting
-	 * by maintenance_work_mem is useful to allow easy testing of the sort
-	 * code path, and may be useful to DBAs as an additional control knob.)
-	 *
-	 * NOTE: this test will need adjustment if a bucket is ever different from
-	 * one page.  Also, "initial index size" accounting does not include the
-	 * metapage, nor the first bitmap page.
-	 */
-	sort_threshold = (maintenance_work_mem * 1024L) / BLCKSZ;
-	if (index->rd_rel->relpersistence != RELPERSISTENCE_TEMP)
-		sort_threshold = Min(sort_threshold, NBuffers);
-	else
-		sort_threshold = Min(sort_threshold, NLocBuffer);
-
-	if (num_buckets >= (uint32) sort_threshold)
-		buildstate.spool = _h_spoolinit(heap, index, num_buckets);
+	if (num_buckets >= hash_sort_threshold(index))
+		buildstate.spool = _h_spoolinit(heap, index, num_buckets, indexInfo);
 	else
 		buildstate.spool = NULL;
 
@@ -167,10 +196,19 @@ hashbuild(Relation heap, Relation index, IndexInfo *indexInfo)
 	buildstate.indtuples = 0;
 	buildstate.heapRel = heap;
 
-	/* do the heap scan */
-	reltuples = table_index_build_scan(heap, index, indexInfo, true, true,
-									   hashbuildCallback,
-									   (void *) &buildstate, NULL);
+	/*
+	 * Do the heap scan.  Parallel builds are only worthwhile (and are only
+	 * performed) when sorting; in that case the workers launched by
+	 * _h_spoolinit have done the scan, and we just wait for them.
+	 */
+	if (buildstate.spool && _h_spool_is_parallel(buildstate.spool))
+		reltuples = _h_parallel_heapscan(buildstate.spool,
+										 &buildstate.indtuples,
+										 &indexInfo->ii_BrokenHotChain);
+	else
+		reltuples = table_index_build_scan(heap, index, indexInfo, true, true,
+										   hashbuildCallback,
+										   (void *) &buildstate, NULL);
 	pgstat_progress_update_param(PROGRESS_CREATEIDX_TUPLES_TOTAL,
 								 buildstate.indtuples);
 
@@ -47,6 +47,8 @@ static void _hash_splitbucket(Relation rel, Buffer metabuf,
 							  uint32 maxbucket,
 							  uint32 highmask, uint32 lowmask);
 static void log_split_page(Relation rel, Buffer buf);
+static int32 _hash_target_ffactor(Relation rel);
+static uint32 _hash_initial_buckets(double num_tuples, uint16 ffactor);
 
 
 /*
@@ -332,8 +334,6 @@ _hash_init(Relation rel, double num_tuples, ForkNumber forkNum)
 	Page		pg;
 	HashMetaPage metap;
 	RegProcedure procid;
-	int32		data_width;
-	int32		item_width;
 	int32		ffactor;
 	uint32		num_buckets;
 	uint32		i;
@@ -351,19 +351,7 @@ _hash_init(Relation rel, double num_tuples, ForkNumber forkNum)
 	 */
 	use_wal = RelationNeedsWAL(rel) || forkNum == INIT_FORKNUM;
 
-	/*
-	 * Determine the target fill factor (in tuples per bucket) for this index.
-	 * The idea is to make the fill factor correspond to pages about as full
-	 * as the user-settable fillfactor parameter says.  We can compute it
-	 * exactly since the index datatype (i.e. uint32 hash key) is fixed-width.
-	 */
-	data_width = sizeof(uint32);
-	item_width = MAXALIGN(sizeof(IndexTupleData)) + MAXALIGN(data_width) +
-		sizeof(ItemIdData);		/* include the line pointer */
-	ffactor = HashGetTargetPageUsage(rel) / item_width;
-	/* keep to a sane range */
-	if (ffactor < 10)
-		ffactor = 10;
+	ffactor = _hash_target_ffactor(rel);
 
 	procid = index_getprocid(rel, 1, HASHSTANDARD_PROC);
 
@@ -492,19 +480,51 @@ _hash_init(Relation rel, double num_tuples, ForkNumber forkNum)
 }
 
 /*
- *	_hash_init_metabuffer() -- Initialize the metadata page of a hash index.
+ *	_hash_estimate_buckets() -- Number of buckets _hash_init() will create
+ *
+ * This is the initial number of buckets of rel, if it is built for an
+ * estimated num_tuples tuples.
  */
-void
-_hash_init_metabuffer(Buffer buf, double num_tuples, RegProcedure procid,
-					  uint16 ffactor, bool initpage)
+uint32
+_hash_estimate_buckets(Relation rel, double num_tuples)
+{
+	return _hash_initial_buckets(num_tuples, _hash_target_ffactor(rel));
+}
+
+/*
+ *	_hash_target_ffactor() -- Target fill factor of a new hash index
+ */
+static int32
+_hash_target_ffactor(Relation rel)
+{
+	int32		data_width;
+	int32		item_width;
+	int32		ffactor;
+
+	/*
+	 * Determine the target fill factor (in tuples per bucket) for this index.
+	 * The idea is to make the fill factor correspond to pages about as full
+	 * as the user-settable fillfactor parameter says.  We can compute it
+	 * exactly since the index datatype (i.e. uint32 hash key) is fixed-width.
+	 */
+	data_width = sizeof(uint32);
+	item_width = MAXALIGN(sizeof(IndexTupleData)) + MAXALIGN(data_width) +
+		sizeof(ItemIdData);		/* include the line pointer */
+	ffactor = HashGetTargetPageUsage(rel) / item_width;
+	/* keep to a sane range */
+	if (ffactor < 10)
+		ffactor = 10;
+
+	return ffactor;
+}
+
+/*
+ *	_hash_initial_buckets() -- Initial number of buckets of a hash index
+ */
+static uint32
+_hash_initial_buckets(double num_tuples, uint16 ffactor)
 {
-	HashMetaPage metap;
-	HashPageOpaque pageopaque;
-	Page		page;
 	double		dnumbuckets;
-	uint32		num_buckets;
-	uint32		spare_index;
-	uint32		lshift;
 
 	/*
 	 * Choose the number of initial bucket pages to match the fill factor
@@ -516,11 +536,28 @@ _hash_init_metabuffer(Buffer buf, double num_tuples, RegProcedure procid,
 	 */
 	dnumbuckets = num_tuples / ffactor;
 	if (dnumbuckets <= 2.0)
-		num_buckets = 2;
+		return 2;
 	else if (dnumbuckets >= (double) 0x40000000)
-		num_buckets = 0x40000000;
+		return 0x40000000;
 	else
-		num_buckets = _hash_get_totalbuckets(_hash_spareindex(dnumbuckets));
+		return _hash_get_totalbuckets(_hash_spareindex(dnumbuckets));
+}
+
+/*
+ *	_hash_init_metabuffer() -- Initialize the metadata page of a hash index.
+ */
+void
+_hash_init_metabuffer(Buffer buf, double num_tuples, RegProcedure procid,
+					  uint16 ffactor, bool initpage)
+{
+	HashMetaPage metap;
+	HashPageOpaque pageopaque;
+	Page		page;
+	uint32		num_buckets;
+	uint32		spare_index;
+	uint32		lshift;
+
+	num_buckets = _hash_initial_buckets(num_tuples, ffactor);
 
 	spare_index = _hash_spareindex(num_buckets);
 	Assert(spare_index < HASH_MAX_SPLITPOINTS);
@@ -988,7 +1025,7 @@ static bool
 _hash_alloc_buckets(Relation rel, BlockNumber firstblock, uint32 nblocks)
 {
 	BlockNumber lastblock;
-	PGAlignedBlock zerobuf;
+	PGIOAlignedBlock zerobuf;
 	Page		page;
 	HashPageOpaque ovflopaque;
 
@@ -13,6 +13,11 @@
  * hash code value.  That's no big problem though, since we'll still have
  * plenty of locality of access.
  *
+ * When a parallel build is requested, the heap scan, hashing and sorting are
+ * divided among parallel workers (and the leader) using the same shared
+ * tuplesort machinery as parallel B-Tree builds; see nbtsort.c.  Only the
+ * leader inserts the merged stream of tuples into the index.
+ *
  *
  * Portions Copyright (c) 1996-2022, PostgreSQL Global Development Group
  * Portions Copyright (c) 1994, Regents of the University of California
@@ -26,21 +31,91 @@
 #include "postgres.h"
 
 #include "access/hash.h"
+#include "access/parallel.h"
+#include "access/relscan.h"
+#include "access/table.h"
+#include "access/tableam.h"
+#include "access/xact.h"
+#include "catalog/index.h"
 #include "commands/progress.h"
+#include "executor/instrument.h"
 #include "miscadmin.h"
 #include "pgstat.h"
 #include "port/pg_bitutils.h"
+#include "storage/condition_variable.h"
+#include "storage/proc.h"
+#include "storage/spin.h"
+#include "tcop/tcopprot.h"		/* pgrminclude ignore */
+#include "utils/rel.h"
+#include "utils/snapmgr.h"
 #include "utils/tuplesort.h"
 
 
+/* Magic numbers for parallel state sharing */
+#define PARALLEL_KEY_HASH_SHARED		UINT64CONST(0xA000000000000001)
+#define PARALLEL_KEY_TUPLESORT			UINT64CONST(0xA000000000000002)
+#define PARALLEL_KEY_QUERY_TEXT			UINT64CONST(0xA000000000000003)
+#define PARALLEL_KEY_WAL_USAGE			UINT64CONST(0xA000000000000004)
+#define PARALLEL_KEY_BUFFER_USAGE		UINT64CONST(0xA000000000000005)
+
+/*
+ * Status for hash index builds performed in parallel.  This is allocated in a
+ * dynamic shared memory segment, followed by the parallel table scan
+ * descriptor.  As in nbtsort.c, there is a separate tuplesort TOC entry.
+ */
+typedef struct HashShared
+{
+	/* Immutable state, needed by workers to set up their own spools */
+	Oid			heaprelid;
+	Oid			indexrelid;
+	bool		isconcurrent;
+	int			scantuplesortstates;
+	uint32		high_mask;
+	uint32		low_mask;
+	uint32		max_buckets;
+
+	/* Signaled by each participant once it has finished its scan and sort */
+	ConditionVariable workersdonecv;
+
+	/* mutex protects the fields below */
+	slock_t		mutex;
+
+	int			nparticipantsdone;
+	double		reltuples;
+	double		indtuples;
+	bool		brokenhotchain;
+} HashShared;
+
+/* c.f. shm_toc_allocate as to why BUFFERALIGN is used */
+#define ParallelTableScanFromHashShared(shared) \
+	(ParallelTableScanDesc) ((char *) (shared) + BUFFERALIGN(sizeof(HashShared)))
+
+/*
+ * Status for leader in parallel hash index build.
+ */
+typedef struct HashLeader
+{
+	ParallelContext *pcxt;		/* parallel context itself */
+	int			nparticipanttuplesorts; /* launched workers, plus leader */
+	HashShared *hashshared;
+	Sharedsort *sharedsort;
+	Snapshot	snapshot;		/* scan's snapshot, if MVCC */
+	WalUsage   *walusage;
+	BufferUsage *bufferusage;
+} HashLeader;
+
 /*
  * Status record for spooling/sorting phase.
  */
 struct HSpool
 {
 	Tuplesortstate *sortstate;	/* state data for tuplesort.c */
+	Relation	heap;
 	Relation	index;
 
+	/* only present in the leader of a parallel build */
+	HashLeader *leader;
+
 	/*
 	 * We sort the hash keys based on the buckets they belong to. Below masks
 	 * are used in _hash_hashkey2bucket to determine the bucket of given hash
@@ -51,15 +126,38 @@ struct HSpool
 	uint32		max_buckets;
 };
 
+/* Working state for a parallel participant's heap scan callback */
+typedef struct HashWorkerState
+{
+	HSpool	   *spool;
+	double		indtuples;
+} HashWorkerState;
+
+static void _h_begin_parallel(HSpool *hspool, bool isconcurrent, int request);
+static void _h_end_parallel(HashLeader *leader);
+static void _h_leader_participate_as_worker(HSpool *hspool);
+static void _h_parallel_scan_and_sort(HSpool *hspool, HashShared *hashshared,
+									  Sharedsort *sharedsort, int sortmem,
+									  bool progress);
+static void _h_build_callback(Relation index, ItemPointer tid, Datum *values,
+							  bool *isnull, bool tupleIsAlive, void *state);
+
 
 /*
  * create and initialize a spool structure
+ *
+ * If indexInfo requests parallel workers, they are launched here, and scan
+ * the heap and sort their share of it before we return.  The caller must
+ * then use _h_parallel_heapscan() instead of scanning the heap itself.
  */
 HSpool *
-_h_spoolinit(Relation heap, Relation index, uint32 num_buckets)
+_h_spoolinit(Relation heap, Relation index, uint32 num_buckets,
+			 struct IndexInfo *indexInfo)
 {
 	HSpool	   *hspool = (HSpool *) palloc0(sizeof(HSpool));
+	SortCoordinate coordinate = NULL;
 
+	hspool->heap = heap;
 	hspool->index = index;
 
 	/*
@@ -74,10 +172,25 @@ _h_spoolinit(Relation heap, Relation index, uint32 num_buckets)
 	hspool->low_mask = (hspool->high_mask >> 1);
 	hspool->max_buckets = num_buckets - 1;
 
+	/* Attempt to launch parallel worker scan when required */
+	if (indexInfo->ii_ParallelWorkers > 0)
+		_h_begin_parallel(hspool, indexInfo->ii_Concurrent,
+						  indexInfo->ii_ParallelWorkers);
+
+	if (hspool->leader)
+	{
+		coordinate = (SortCoordinate) palloc0(sizeof(SortCoordinateData));
+		coordinate->isWorker = false;
+		coordinate->nParticipants = hspool->leader->nparticipanttuplesorts;
+		coordinate->sharedsort = hspool->leader->sharedsort;
+	}
+
 	/*
 	 * We size the sort area as maintenance_work_mem rather than work_mem to
 	 * speed index creation.  This should be OK since a single backend can't
-	 * run multiple index creations in parallel.
+	 * run multiple index creations in parallel.  In a parallel build, the
+	 * leader's sort only merges the workers' runs (see _bt_spools_heapscan
+	 * for why the overall budget is still respected).
 	 */
 	hspool->sortstate = tuplesort_begin_index_hash(heap,
 												   index,
@@ -85,7 +198,7 @@ _h_spoolinit(Relation heap, Relation index, uint32 num_buckets)
 												   hspool->low_mask,
 												   hspool->max_buckets,
 												   maintenance_work_mem,
-												   NULL,
+												   coordinate,
 												   TUPLESORT_NONE);
 
 	return hspool;
@@ -93,14 +206,27 @@ _h_spoolinit(Relation heap, Relation index, uint32 num_buckets)
 
 /*
  * clean up a spool structure and its substructures.
+ *
+ * This also ends parallel mode, if the spool was filled in parallel.
  */
 void
 _h_spooldestroy(HSpool *hspool)
 {
 	tuplesort_end(hspool->sortstate);
+	if (hspool->leader)
+		_h_end_parallel(hspool->leader);
 	pfree(hspool);
 }
 
+/*
+ * Did _h_spoolinit() launch parallel workers to fill the spool?
+ */
+bool
+_h_spool_is_parallel(HSpool *hspool)
+{
+	return hspool->leader != NULL;
+}
+
 /*
  * spool an index entry into the sort file.
  */
@@ -150,3 +276,380 @@ _h_indexbuild(HSpool *hspool, Relation heapRel)
 									 ++tups_done);
 	}
 }
+
+/*
+ * Create parallel context, and launch workers for leader.
+ *
+ * This follows _bt_begin_parallel(): if no DSM segment is available or no
+ * worker could be launched, hspool->leader is left unset and the caller
+ * performs a serial build.  Otherwise the leader joins the heap scan as a
+ * worker before returning.
+ */
+static void
+_h_begin_parallel(HSpool *hspool, bool isconcurrent, int request)
+{
+	ParallelContext *pcxt;
+	int			scantuplesortstates;
+	Snapshot	snapshot;
+	Size		estshared;
+	Size		estsort;
+	HashShared *hashshared;
+	Sharedsort *sharedsort;
+	HashLeader *leader = (HashLeader *) palloc0(sizeof(HashLeader));
+	WalUsage   *walusage;
+	BufferUsage *bufferusage;
+	int			querylen;
+
+	EnterParallelMode();
+	Assert(request > 0);
+	pcxt = CreateParallelContext("postgres", "_hash_parallel_build_main",
+								 request);
+
+	/* the leader always participates */
+	scantuplesortstates = request + 1;
+
+	/* See _bt_begin_parallel about the choice of snapshot */
+	if (!isconcurrent)
+		snapshot = SnapshotAny;
+	else
+		snapshot = RegisterSnapshot(GetTransactionSnapshot());
+
+	estshared = add_size(BUFFERALIGN(sizeof(HashShared)),
+						 table_parallelscan_estimate(hspool->heap, snapshot));
+	shm_toc_estimate_chunk(&pcxt->estimator, estshared);
+	estsort = tuplesort_estimate_shared(scantuplesortstates);
+	shm_toc_estimate_chunk(&pcxt->estimator, estsort);
+	shm_toc_estimate_keys(&pcxt->estimator, 2);
+
+	shm_toc_estimate_chunk(&pcxt->estimator,
+						   mul_size(sizeof(WalUsage), pcxt->nworkers));
+	shm_toc_estimate_keys(&pcxt->estimator, 1);
+	shm_toc_estimate_chunk(&pcxt->estimator,
+						   mul_size(sizeof(BufferUsage), pcxt->nworkers));
+	shm_toc_estimate_keys(&pcxt->estimator, 1);
+
+	if (debug_query_string)
+	{
+		querylen = strlen(debug_query_string);
+		shm_toc_estimate_chunk(&pcxt->estimator, querylen + 1);
+		shm_toc_estimate_keys(&pcxt->estimator, 1);
+	}
+	else
+		querylen = 0;			/* keep compiler quiet */
+
+	InitializeParallelDSM(pcxt);
+
+	/* If no DSM segment was available, back out (do serial build) */
+	if (pcxt->seg == NULL)
+	{
+		if (IsMVCCSnapshot(snapshot))
+			UnregisterSnapshot(snapshot);
+		DestroyParallelContext(pcxt);
+		ExitParallelMode();
+		return;
+	}
+
+	hashshared = (HashShared *) shm_toc_allocate(pcxt->toc, estshared);
+	hashshared->heaprelid = RelationGetRelid(hspool->heap);
+	hashshared->indexrelid = RelationGetRelid(hspool->index);
+	hashshared->isconcurrent = isconcurrent;
+	hashshared->scantuplesortstates = scantuplesortstates;
+	hashshared->high_mask = hspool->high_mask;
+	hashshared->low_mask = hspool->low_mask;
+	hashshared->max_buckets = hspool->max_buckets;
+	ConditionVariableInit(&hashshared->workersdonecv);
+	SpinLockInit(&hashshared->mutex);
+	hashshared->nparticipantsdone = 0;
+	hashshared->reltuples = 0.0;
+	hashshared->indtuples = 0.0;
+	hashshared->brokenhotchain = false;
+	table_parallelscan_initialize(hspool->heap,
+								  ParallelTableScanFromHashShared(hashshared),
+								  snapshot);
+
+	sharedsort = (Sharedsort *) shm_toc_allocate(pcxt->toc, estsort);
+	tuplesort_initialize_shared(sharedsort, scantuplesortstates,
+								pcxt->seg);
+
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_HASH_SHARED, hashshared);
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_TUPLESORT, sharedsort);
+
+	if (debug_query_string)
+	{
+		char	   *sharedquery;
+
+		sharedquery = (char *) shm_toc_allocate(pcxt->toc, querylen + 1);
+		memcpy(sharedquery, debug_query_string, querylen + 1);
+		shm_toc_insert(pcxt->toc, PARALLEL_KEY_QUERY_TEXT, sharedquery);
+	}
+
+	walusage = shm_toc_allocate(pcxt->toc,
+								mul_size(sizeof(WalUsage), pcxt->nworkers));
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_WAL_USAGE, walusage);
+	bufferusage = shm_toc_allocate(pcxt->toc,
+								   mul_size(sizeof(BufferUsage), pcxt->nworkers));
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_BUFFER_USAGE, bufferusage);
+
+	LaunchParallelWorkers(pcxt);
+	leader->pcxt = pcxt;
+	leader->nparticipanttuplesorts = pcxt->nworkers_launched + 1;
+	leader->hashshared = hashshared;
+	leader->sharedsort = sharedsort;
+	leader->snapshot = snapshot;
+	leader->walusage = walusage;
+	leader->bufferusage = bufferusage;
+
+	/* If no workers were successfully launched, back out (do serial build) */
+	if (pcxt->nworkers_launched == 0)
+	{
+		_h_end_parallel(leader);
+		return;
+	}
+
+	hspool->leader = leader;
+
+	/* Join heap scan ourselves */
+	_h_leader_participate_as_worker(hspool);
+
+	/* Make sure that the failure-to-start case will not hang forever */
+	WaitForParallelWorkersToAttach(pcxt);
+}
+
+/*
+ * Shut down workers, destroy parallel context, and end parallel mode.
+ */
+static void
+_h_end_parallel(HashLeader *leader)
+{
+	int			i;
+
+	WaitForParallelWorkersToFinish(leader->pcxt);
+
+	for (i = 0; i < leader->pcxt->nworkers_launched; i++)
+		InstrAccumParallelQuery(&leader->bufferusage[i], &leader->walusage[i]);
+
+	if (IsMVCCSnapshot(leader->snapshot))
+		UnregisterSnapshot(leader->snapshot);
+	DestroyParallelContext(leader->pcxt);
+	ExitParallelMode();
+}
+
+/*
+ * Within leader, wait for all participants to finish scanning and sorting.
+ *
+ * Sets *indtuples and *brokenhotchain, and returns the total number of heap
+ * tuples scanned, for the caller's ambuild statistics.
+ */
+double
+_h_parallel_heapscan(HSpool *hspool, double *indtuples, bool *brokenhotchain)
+{
+	HashShared *hashshared = hspool->leader->hashshared;
+	int			nparticipanttuplesorts;
+	double		reltuples;
+
+	nparticipanttuplesorts = hspool->leader->nparticipanttuplesorts;
+	for (;;)
+	{
+		SpinLockAcquire(&hashshared->mutex);
+		if (hashshared->nparticipantsdone == nparticipanttuplesorts)
+		{
+			*indtuples = hashshared->indtuples;
+			if (hashshared->brokenhotchain)
+				*brokenhotchain = true;
+			reltuples = hashshared->reltuples;
+			SpinLockRelease(&hashshared->mutex);
+			break;
+		}
+		SpinLockRelease(&hashshared->mutex);
+
+		ConditionVariableSleep(&hashshared->workersdonecv,
+							   WAIT_EVENT_PARALLEL_CREATE_INDEX_SCAN);
+	}
+
+	ConditionVariableCancelSleep();
+
+	return reltuples;
+}
+
+/*
+ * Within leader, participate as a parallel worker.
+ */
+static void
+_h_leader_participate_as_worker(HSpool *hspool)
+{
+	HashLeader *leader = hspool->leader;
+	HSpool	   *leaderworker;
+
+	leaderworker = (HSpool *) palloc0(sizeof(HSpool));
+	leaderworker->heap = hspool->heap;
+	leaderworker->index = hspool->index;
+	leaderworker->high_mask = hspool->high_mask;
+	leaderworker->low_mask = hspool->low_mask;
+	leaderworker->max_buckets = hspool->max_buckets;
+
+	_h_parallel_scan_and_sort(leaderworker, leader->hashshared,
+							  leader->sharedsort,
+							  maintenance_work_mem / leader->nparticipanttuplesorts,
+							  true);
+	pfree(leaderworker);
+}
+
+/*
+ * Perform work within a launched parallel process.
+ */
+void
+_hash_parallel_build_main(dsm_segment *seg, shm_toc *toc)
+{
+	char	   *sharedquery;
+	HSpool	   *hspool;
+	HashShared *hashshared;
+	Sharedsort *sharedsort;
+	Relation	heapRel;
+	Relation	indexRel;
+	LOCKMODE	heapLockmode;
+	LOCKMODE	indexLockmode;
+	WalUsage   *walusage;
+	BufferUsage *bufferusage;
+
+	/*
+	 * The only possible status flag that can be set to the parallel worker is
+	 * PROC_IN_SAFE_IC.
+	 */
+	Assert((MyProc->statusFlags == 0) ||
+		   (MyProc->statusFlags == PROC_IN_SAFE_IC));
+
+	/* Set debug_query_string for individual workers first */
+	sharedquery = shm_toc_lookup(toc, PARALLEL_KEY_QUERY_TEXT, true);
+	debug_query_string = sharedquery;
+
+	/* Report the query string from leader */
+	pgstat_report_activity(STATE_RUNNING, debug_query_string);
+
+	hashshared = shm_toc_lookup(toc, PARALLEL_KEY_HASH_SHARED, false);
+
+	/* Open relations using lock modes known to be obtained by index.c */
+	if (!hashshared->isconcurrent)
+	{
+		heapLockmode = ShareLock;
+		indexLockmode = AccessExclusiveLock;
+	}
+	else
+	{
+		heapLockmode = ShareUpdateExclusiveLock;
+		indexLockmode = RowExclusiveLock;
+	}
+
+	heapRel = table_open(hashshared->heaprelid, heapLockmode);
+	indexRel = index_open(hashshared->indexrelid, indexLockmode);
+
+	hspool = (HSpool *) palloc0(sizeof(HSpool));
+	hspool->heap = heapRel;
+	hspool->index = indexRel;
+	hspool->high_mask = hashshared->high_mask;
+	hspool->low_mask = hashshared->low_mask;
+	hspool->max_buckets = hashshared->max_buckets;
+
+	sharedsort = shm_toc_lookup(toc, PARALLEL_KEY_TUPLESORT, false);
+	tuplesort_attach_shared(sharedsort, seg);
+
+	/* Prepare to track buffer usage during parallel execution */
+	InstrStartParallelQuery();
+
+	_h_parallel_scan_and_sort(hspool, hashshared, sharedsort,
+							  maintenance_work_mem / hashshared->scantuplesortstates,
+							  false);
+
+	/* Report WAL/buffer usage during parallel execution */
+	bufferusage = shm_toc_lookup(toc, PARALLEL_KEY_BUFFER_USAGE, false);
+	walusage = shm_toc_lookup(toc, PARALLEL_KEY_WAL_USAGE, false);
+	InstrEndParallelQuery(&bufferusage[ParallelWorkerNumber],
+						  &walusage[ParallelWorkerNumber]);
+
+	index_close(indexRel, indexLockmode);
+	table_close(heapRel, heapLockmode);
+}
+
+/*
+ * Perform a participant's portion of a parallel scan and sort.
+ *
+ * sortmem is the amount of working memory to use within each participant,
+ * expressed in KBs.
+ */
+static void
+_h_parallel_scan_and_sort(HSpool *hspool, HashShared *hashshared,
+						  Sharedsort *sharedsort, int sortmem, bool progress)
+{
+	SortCoordinate coordinate;
+	HashWorkerState workerstate;
+	TableScanDesc scan;
+	double		reltuples;
+	IndexInfo  *indexInfo;
+
+	coordinate = palloc0(sizeof(SortCoordinateData));
+	coordinate->isWorker = true;
+	coordinate->nParticipants = -1;
+	coordinate->sharedsort = sharedsort;
+
+	hspool->sortstate = tuplesort_begin_index_hash(hspool->heap,
+												   hspool->index,
+												   hspool->high_mask,
+												   hspool->low_mask,
+												   hspool->max_buckets,
+												   sortmem, coordinate,
+												   TUPLESORT_NONE);
+
+	workerstate.spool = hspool;
+	workerstate.indtuples = 0;
+
+	/* Join parallel scan */
+	indexInfo = BuildIndexInfo(hspool->index);
+	indexInfo->ii_Concurrent = hashshared->isconcurrent;
+	scan = table_beginscan_parallel(hspool->heap,
+									ParallelTableScanFromHashShared(hashshared));
+	reltuples = table_index_build_scan(hspool->heap, hspool->index, indexInfo,
+									   true, progress, _h_build_callback,
+									   (void *) &workerstate, scan);
+
+	/* Execute this participant's part of the sort */
+	tuplesort_performsort(hspool->sortstate);
+
+	SpinLockAcquire(&hashshared->mutex);
+	hashshared->nparticipantsdone++;
+	hashshared->reltuples += reltuples;
+	hashshared->indtuples += workerstate.indtuples;
+	if (indexInfo->ii_BrokenHotChain)
+		hashshared->brokenhotchain = true;
+	SpinLockRelease(&hashshared->mutex);
+
+	/* Notify leader */
+	ConditionVariableSignal(&hashshared->workersdonecv);
+
+	/* We can end tuplesorts immediately */
+	tuplesort_end(hspool->sortstate);
+}
+
+/*
+ * Per-tuple callback for a parallel participant's table_index_build_scan
+ */
+static void
+_h_build_callback(Relation index,
+				  ItemPointer tid,
+				  Datum *values,
+				  bool *isnull,
+				  bool tupleIsAlive,
+				  void *state)
+{
+	HashWorkerState *workerstate = (HashWorkerState *) state;
+	Datum		index_values[1];
+	bool		index_isnull[1];
+
+	/* convert data to a hash key; on failure, do not insert anything */
+	if (!_hash_convert_tuple(index,
+							 values, isnull,
+							 index_values, index_isnull))
+		return;
+
+	_h_spool(workerstate->spool, tid, index_values, index_isnull);
+
+	workerstate->indtuples += 1;
+}
@@ -1813,6 +1813,72 @@ heap_hot_search_buffer(ItemPointer tid, Relation relation, Buffer buffer,
 	return false;
 }
 
+/*
+ *	heap_page_visible_to_snapshot - are all tuples on a page visible?
+ *
+ * Returns true if every line pointer on the page is a normal tuple that is
+ * visible to the given MVCC snapshot, and sets *maxoff to the page's current
+ * max offset number.  The caller can then treat any TID on this page with an
+ * offset up to *maxoff as referencing a visible tuple, without visiting the
+ * heap, for as long as it keeps using the same snapshot: none of those
+ * tuples can be pruned away or replaced while the snapshot's xmin holds back
+ * the removal horizon, and a concurrent deletion can't make them invisible
+ * to the snapshot either.  Tuples added to the page later are not covered,
+ * which is why *maxoff is returned.
+ *
+ * Note that pages with any redirect or dead line pointers, or any tuple
+ * updated by a transaction visible to us, fail the test, so the caller
+ * needn't worry about HOT chains.
+ *
+ * The caller must have a pin on the buffer, but not a lock.
+ */
+bool
+heap_page_visible_to_snapshot(Relation relation, Buffer buffer,
+							  Snapshot snapshot, OffsetNumber *maxoff)
+{
+	Page		page;
+	OffsetNumber offnum,
+				pagemaxoff;
+	bool		all_visible = true;
+
+	Assert(IsMVCCSnapshot(snapshot));
+
+	LockBuffer(buffer, BUFFER_LOCK_SHARE);
+
+	page = BufferGetPage(buffer);
+	pagemaxoff = PageGetMaxOffsetNumber(page);
+
+	for (offnum = FirstOffsetNumber;
+		 offnum <= pagemaxoff;
+		 offnum = OffsetNumberNext(offnum))
+	{
+		ItemId		lp = PageGetItemId(page, offnum);
+		HeapTupleData tuple;
+
+		if (!ItemIdIsNormal(lp))
+		{
+			all_visible = false;
+			break;
+		}
+
+		tuple.t_data = (HeapTupleHeader) PageGetItem(page, lp);
+		tuple.t_len = ItemIdGetLength(lp);
+		tuple.t_tableOid = RelationGetRelid(relation);
+		ItemPointerSet(&tuple.t_self, BufferGetBlockNumber(buffer), offnum);
+
+		if (!HeapTupleSatisfiesVisibility(&tuple, snapshot, buffer))
+		{
+			all_visible = false;
+			break;
+		}
+	}
+
+	LockBuffer(buffer, BUFFER_LOCK_UNLOCK);
+
+	*maxoff = pagemaxoff;
+	return all_visible;
+}
+
 /*
  *	heap_get_latest_tid -  get the latest tid of a specified tuple
  *
@@ -21,12 +21,16 @@
 #include "access/xlog.h"
 #include "access/xloginsert.h"
 #include "catalog/catalog.h"
+#include "catalog/pg_am.h"
 #include "miscadmin.h"
 #include "pgstat.h"
+#include "postmaster/autovacuum.h"
 #include "storage/bufmgr.h"
+#include "storage/lmgr.h"
 #include "utils/snapmgr.h"
 #include "utils/rel.h"
 #include "utils/snapmgr.h"
+#include "utils/syscache.h"
 
 /* Working data for heap_page_prune and subroutines */
 typedef struct
@@ -90,6 +94,9 @@ static void heap_prune_record_redirect(PruneState *prstate,
 static void heap_prune_record_dead(PruneState *prstate, OffsetNumber offnum);
 static void heap_prune_record_unused(PruneState *prstate, OffsetNumber offnum);
 static void page_verify_redirects(Page page);
+static void heap_page_prune_opt_internal(Relation relation, Buffer buffer,
+										 bool defer);
+static void heap_page_prune_defer(Relation relation, BlockNumber blkno);
 
 
 /*
@@ -99,6 +106,11 @@ static void page_verify_redirects(Page page);
  * only if the page heuristically looks like a candidate for pruning and we
  * can acquire buffer cleanup lock without blocking.
  *
+ * If the page looks prunable but the cleanup lock isn't available right now
+ * (typically because other backends have the page pinned), we ask autovacuum
+ * to try again later rather than leave the page unpruned until the next
+ * VACUUM; see heap_page_prune_deferred.
+ *
  * Note: this is called quite often.  It's important that it fall out quickly
  * if there's not any use in pruning.
  *
@@ -106,6 +118,107 @@ static void page_verify_redirects(Page page);
  */
 void
 heap_page_prune_opt(Relation relation, Buffer buffer)
+{
+	heap_page_prune_opt_internal(relation, buffer, true);
+}
+
+/*
+ * heap_page_prune_deferred
+ *		Prune a page for which heap_page_prune_opt couldn't get a cleanup lock
+ *
+ * This is run by an autovacuum worker, as an AVW_HeapPrunePage work item.
+ * We recheck the same heuristics as heap_page_prune_opt did; the page may
+ * well have been pruned by somebody else in the meantime.  Pruning also sets
+ * hint bits on every remaining tuple whose inserting or deleting transaction
+ * has finished, so the foreground backends that read the page next don't
+ * have to dirty it themselves.
+ *
+ * We don't wait for anything: if we can't lock the relation, or still can't
+ * get a cleanup lock on the buffer, we just give up.
+ */
+void
+heap_page_prune_deferred(Oid relid, BlockNumber blkno)
+{
+	Relation	relation;
+	Buffer		buffer;
+
+	if (!ConditionalLockRelationOid(relid, AccessShareLock))
+		return;
+
+	/* The relation could have been dropped since the request was made */
+	if (!SearchSysCacheExists1(RELOID, ObjectIdGetDatum(relid)))
+	{
+		UnlockRelationOid(relid, AccessShareLock);
+		return;
+	}
+
+	relation = relation_open(relid, NoLock);
+
+	/* ... or truncated, or replaced by something else */
+	if ((relation->rd_rel->relkind != RELKIND_RELATION &&
+		 relation->rd_rel->relkind != RELKIND_MATVIEW &&
+		 relation->rd_rel->relkind != RELKIND_TOASTVALUE) ||
+		relation->rd_rel->relam != HEAP_TABLE_AM_OID)
+	{
+		relation_close(relation, AccessShareLock);
+		return;
+	}
+	if (blkno >= RelationGetNumberOfBlocks(relation))
+	{
+		relation_close(relation, AccessShareLock);
+		return;
+	}
+
+	PushActiveSnapshot(GetTransactionSnapshot());
+
+	buffer = ReadBufferExtended(relation, MAIN_FORKNUM, blkno, RBM_NORMAL,
+								NULL);
+	heap_page_prune_opt_internal(relation, buffer, false);
+	ReleaseBuffer(buffer);
+
+	PopActiveSnapshot();
+
+	relation_close(relation, AccessShareLock);
+}
+
+/*
+ * Ask autovacuum to prune a page later, on behalf of heap_page_prune_opt.
+ *
+ * The work item queue is small and shared with other kinds of requests, so
+ * AutoVacuumRequestWork only accepts a limited number of these, and ignores
+ * duplicates.  It checks for a full queue without taking AutovacuumLock; we
+ * also remember the last page we asked about, so that a backend repeatedly
+ * visiting a busy page doesn't hammer the lock.
+ */
+static void
+heap_page_prune_defer(Relation relation, BlockNumber blkno)
+{
+	static Oid	last_relid = InvalidOid;
+	static BlockNumber last_blkno = InvalidBlockNumber;
+
+	/* autovacuum can't process other backends' temp tables */
+	if (RelationUsesLocalBuffers(relation))
+		return;
+
+	if (!AutoVacuumingActive() || IsAutoVacuumWorkerProcess())
+		return;
+
+	if (RelationGetRelid(relation) == last_relid && blkno == last_blkno)
+		return;
+
+	last_relid = RelationGetRelid(relation);
+	last_blkno = blkno;
+
+	(void) AutoVacuumRequestWork(AVW_HeapPrunePage,
+								 RelationGetRelid(relation), blkno);
+}
+
+/*
+ * Workhorse for heap_page_prune_opt and heap_page_prune_deferred.  If defer
+ * is true, request a deferred prune when the cleanup lock isn't available.
+ */
+static void
+heap_page_prune_opt_internal(Relation relation, Buffer buffer, bool defer)
 {
 	Page		page = BufferGetPage(buffer);
 	TransactionId prune_xid;
@@ -193,7 +306,11 @@ heap_page_prune_opt(Relation relation, Buffer buffer)
 	{
 		/* OK, try to get exclusive buffer lock */
 		if (!ConditionalLockBufferForCleanup(buffer))
+		{
+			if (defer)
+				heap_page_prune_defer(relation, BufferGetBlockNumber(buffer));
 			return;
+		}
 
 		/*
 		 * Now that we have buffer lock, get accurate information about the
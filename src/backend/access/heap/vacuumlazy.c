@@ -12,9 +12,13 @@
  * autovacuum_work_mem) memory space to keep track of dead TIDs.  We initially
  * allocate an array of TIDs of that size, with an upper limit that depends on
  * table size (this limit ensures we don't allocate a huge area uselessly for
- * vacuuming small tables).  If the array threatens to overflow, we must call
- * lazy_vacuum to vacuum indexes (and to vacuum the pages that we've pruned).
- * This frees up the memory space dedicated to storing dead TIDs.
+ * vacuuming small tables).  The array is allocated as a "huge" chunk, so it
+ * is not subject to the usual 1GB palloc limit; with a large enough memory
+ * setting, even very large tables need only a single round of index
+ * vacuuming.  The number of TIDs is still limited to INT_MAX.  If the array
+ * threatens to overflow, we must call lazy_vacuum to vacuum indexes (and to
+ * vacuum the pages that we've pruned).  This frees up the memory space
+ * dedicated to storing dead TIDs.
  *
  * In practice VACUUM will often complete its initial pass over the target
  * heap relation without ever running out of space to store TIDs.  This means
@@ -63,6 +67,7 @@
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "utils/pg_rusage.h"
+#include "utils/spccache.h"
 #include "utils/timestamp.h"
 
 
@@ -161,6 +166,8 @@ typedef struct LVRelState
 	/* Buffer access strategy and parallel vacuum state */
 	BufferAccessStrategy bstrategy;
 	ParallelVacuumState *pvs;
+	/* # of heap pages to prefetch ahead of both heap passes (0 disables) */
+	int			prefetch_maximum;
 
 	/* rel's initial relfrozenxid and relminmxid */
 	TransactionId relfrozenxid;
@@ -173,6 +180,8 @@ typedef struct LVRelState
 	/* VACUUM operation's target cutoffs for freezing XIDs and MultiXactIds */
 	TransactionId FreezeLimit;
 	MultiXactId MultiXactCutoff;
+	/* Pages with an older LSN are frozen eagerly (Invalid disables) */
+	XLogRecPtr	EagerFreezeLSN;
 	/* Tracks oldest extant XID/MXID for setting relfrozenxid/relminmxid */
 	TransactionId NewRelfrozenXid;
 	MultiXactId NewRelminMxid;
@@ -201,6 +210,8 @@ typedef struct LVRelState
 	BlockNumber lpdead_item_pages;	/* # pages with LP_DEAD items */
 	BlockNumber missed_dead_pages;	/* # pages with missed dead tuples */
 	BlockNumber nonempty_pages; /* actually, last nonempty page + 1 */
+	BlockNumber frozen_pages;	/* # pages with newly frozen tuples */
+	BlockNumber eager_frozen_pages; /* # of those frozen eagerly */
 
 	/* Statistics output by us, for table */
 	double		new_rel_tuples; /* new estimated total # of tuples */
@@ -216,6 +227,9 @@ typedef struct LVRelState
 	int64		live_tuples;	/* # live tuples remaining */
 	int64		recently_dead_tuples;	/* # dead, but not yet removable */
 	int64		missed_dead_tuples; /* # removable, but not removed */
+	int64		tuples_frozen;	/* # tuples frozen */
+	int64		freeze_wal_records; /* # freeze WAL records written */
+	uint64		freeze_wal_bytes;	/* size of those records */
 } LVRelState;
 
 /*
@@ -236,6 +250,19 @@ typedef struct LVPagePruneState
 	TransactionId visibility_cutoff_xid;	/* For recovery conflicts */
 } LVPagePruneState;
 
+/*
+ * State of lazy_scan_heap's prefetch cursor, which runs ahead of the scan
+ * making its own lazy_scan_skip decisions
+ */
+typedef struct LVPrefetchState
+{
+	BlockNumber next_block;		/* next block the cursor will consider */
+	BlockNumber next_unskippable_block; /* next_block's range ends here */
+	bool		skipping_current_range; /* skip the rest of that range? */
+	int			pages_ahead;	/* # prefetched pages not yet scanned */
+	Buffer		vmbuffer;		/* cursor's own VM pin */
+} LVPrefetchState;
+
 /* Struct for saving and restoring vacuum error information. */
 typedef struct LVSavedErrInfo
 {
@@ -250,7 +277,12 @@ static void lazy_scan_heap(LVRelState *vacrel);
 static BlockNumber lazy_scan_skip(LVRelState *vacrel, Buffer *vmbuffer,
 								  BlockNumber next_block,
 								  bool *next_unskippable_allvis,
-								  bool *skipping_current_range);
+								  bool *skipping_current_range,
+								  bool *skippedallvis);
+static void lazy_scan_prefetch(LVRelState *vacrel, BlockNumber blkno,
+							   BlockNumber next_unskippable_block,
+							   bool skipping_current_range,
+							   LVPrefetchState *prefetch);
 static bool lazy_scan_new_or_empty(LVRelState *vacrel, Buffer buf,
 								   BlockNumber blkno, Page page,
 								   bool sharelock, Buffer vmbuffer);
@@ -463,6 +495,12 @@ heap_vacuum_rel(Relation rel, VacuumParams *params,
 	}
 
 	vacrel->bstrategy = bstrategy;
+#ifdef USE_PREFETCH
+	vacrel->prefetch_maximum =
+		get_tablespace_maintenance_io_concurrency(rel->rd_rel->reltablespace);
+#else
+	vacrel->prefetch_maximum = 0;
+#endif
 	vacrel->relfrozenxid = rel->rd_rel->relfrozenxid;
 	vacrel->relminmxid = rel->rd_rel->relminmxid;
 	vacrel->old_live_tuples = rel->rd_rel->reltuples;
@@ -473,6 +511,8 @@ heap_vacuum_rel(Relation rel, VacuumParams *params,
 	vacrel->lpdead_item_pages = 0;
 	vacrel->missed_dead_pages = 0;
 	vacrel->nonempty_pages = 0;
+	vacrel->frozen_pages = 0;
+	vacrel->eager_frozen_pages = 0;
 	/* dead_items_alloc allocates vacrel->dead_items later on */
 
 	/* Allocate/initialize output statistics state */
@@ -488,6 +528,9 @@ heap_vacuum_rel(Relation rel, VacuumParams *params,
 	vacrel->live_tuples = 0;
 	vacrel->recently_dead_tuples = 0;
 	vacrel->missed_dead_tuples = 0;
+	vacrel->tuples_frozen = 0;
+	vacrel->freeze_wal_records = 0;
+	vacrel->freeze_wal_bytes = 0;
 
 	/*
 	 * Determine the extent of the blocks that we'll scan in lazy_scan_heap,
@@ -512,6 +555,25 @@ heap_vacuum_rel(Relation rel, VacuumParams *params,
 	vacrel->FreezeLimit = FreezeLimit;
 	/* MultiXactCutoff controls MXID freezing (always <= OldestMxact) */
 	vacrel->MultiXactCutoff = MultiXactCutoff;
+
+	/*
+	 * EagerFreezeLSN controls page-level eager freezing.  Pages last modified
+	 * at least vacuum_eager_freeze_wal_age worth of WAL ago are deemed cold:
+	 * when such a page is about to be set all-visible, we freeze all of its
+	 * tuples (using OldestXmin rather than FreezeLimit as the cutoff) so that
+	 * it can be set all-frozen too.  That spreads the cost of freezing over
+	 * ordinary VACUUMs, rather than leaving it all to a later aggressive
+	 * VACUUM that has to revisit every all-visible page.
+	 */
+	vacrel->EagerFreezeLSN = InvalidXLogRecPtr;
+	if (vacuum_eager_freeze_wal_age >= 0)
+	{
+		XLogRecPtr	insertlsn = GetXLogInsertRecPtr();
+		uint64		age = (uint64) vacuum_eager_freeze_wal_age * 1024 * 1024;
+
+		if (insertlsn > age)
+			vacrel->EagerFreezeLSN = insertlsn - age;
+	}
 	/* Initialize state used to track oldest extant XID/MXID */
 	vacrel->NewRelfrozenXid = OldestXmin;
 	vacrel->NewRelminMxid = OldestMxact;
@@ -721,6 +783,17 @@ heap_vacuum_rel(Relation rel, VacuumParams *params,
 								 _("new relminmxid: %u, which is %d MXIDs ahead of previous value\n"),
 								 vacrel->NewRelminMxid, diff);
 			}
+			appendStringInfo(&buf,
+							 _("frozen: %u pages from table (%.2f%% of total) had %lld tuples frozen, %u pages frozen eagerly\n"),
+							 vacrel->frozen_pages,
+							 orig_rel_pages == 0 ? 100.0 :
+							 100.0 * vacrel->frozen_pages / orig_rel_pages,
+							 (long long) vacrel->tuples_frozen,
+							 vacrel->eager_frozen_pages);
+			appendStringInfo(&buf,
+							 _("freeze WAL usage: %lld records, %llu bytes\n"),
+							 (long long) vacrel->freeze_wal_records,
+							 (unsigned long long) vacrel->freeze_wal_bytes);
 			if (vacrel->do_index_vacuuming)
 			{
 				if (vacrel->nindexes == 0 || vacrel->num_index_scans == 0)
@@ -851,6 +924,7 @@ lazy_scan_heap(LVRelState *vacrel)
 				next_fsm_block_to_vacuum = 0;
 	VacDeadItems *dead_items = vacrel->dead_items;
 	Buffer		vmbuffer = InvalidBuffer;
+	LVPrefetchState prefetch;
 	bool		next_unskippable_allvis,
 				skipping_current_range;
 	const int	initprog_index[] = {
@@ -866,10 +940,16 @@ lazy_scan_heap(LVRelState *vacrel)
 	initprog_val[2] = dead_items->max_items;
 	pgstat_progress_update_multi_param(3, initprog_index, initprog_val);
 
+	/* Prefetch cursor gets positioned when we scan the first page */
+	prefetch.next_block = 0;
+	prefetch.pages_ahead = 0;
+	prefetch.vmbuffer = InvalidBuffer;
+
 	/* Set up an initial range of skippable blocks using the visibility map */
 	next_unskippable_block = lazy_scan_skip(vacrel, &vmbuffer, 0,
 											&next_unskippable_allvis,
-											&skipping_current_range);
+											&skipping_current_range,
+											&vacrel->skippedallvis);
 	for (blkno = 0; blkno < rel_pages; blkno++)
 	{
 		Buffer		buf;
@@ -887,7 +967,8 @@ lazy_scan_heap(LVRelState *vacrel)
 			next_unskippable_block = lazy_scan_skip(vacrel, &vmbuffer,
 													blkno + 1,
 													&next_unskippable_allvis,
-													&skipping_current_range);
+													&skipping_current_range,
+													&vacrel->skippedallvis);
 
 			Assert(next_unskippable_block >= blkno + 1);
 		}
@@ -903,6 +984,10 @@ lazy_scan_heap(LVRelState *vacrel)
 			all_visible_according_to_vm = true;
 		}
 
+		/* Start reading pages we know we'll scan soon */
+		lazy_scan_prefetch(vacrel, blkno, next_unskippable_block,
+						   skipping_current_range, &prefetch);
+
 		vacrel->scanned_pages++;
 
 		/* Report as block scanned, update error traceback information */
@@ -947,6 +1032,11 @@ lazy_scan_heap(LVRelState *vacrel)
 				ReleaseBuffer(vmbuffer);
 				vmbuffer = InvalidBuffer;
 			}
+			if (BufferIsValid(prefetch.vmbuffer))
+			{
+				ReleaseBuffer(prefetch.vmbuffer);
+				prefetch.vmbuffer = InvalidBuffer;
+			}
 
 			/* Perform a round of index and heap vacuuming */
 			vacrel->consider_bypass_optimization = false;
@@ -1239,6 +1329,8 @@ lazy_scan_heap(LVRelState *vacrel)
 	vacrel->blkno = InvalidBlockNumber;
 	if (BufferIsValid(vmbuffer))
 		ReleaseBuffer(vmbuffer);
+	if (BufferIsValid(prefetch.vmbuffer))
+		ReleaseBuffer(prefetch.vmbuffer);
 
 	/* report that everything is now scanned */
 	pgstat_progress_update_param(PROGRESS_VACUUM_HEAP_BLKS_SCANNED, blkno);
@@ -1297,12 +1389,15 @@ lazy_scan_heap(LVRelState *vacrel)
  * was concurrently cleared, though.  All that matters is that caller scan all
  * pages whose tuples might contain XIDs < OldestXmin, or MXIDs < OldestMxact.
  * (Actually, non-aggressive VACUUMs can choose to skip all-visible pages with
- * older XIDs/MXIDs.  The vacrel->skippedallvis flag will be set here when the
- * choice to skip such a range is actually made, making everything safe.)
+ * older XIDs/MXIDs.  *skippedallvis will be set here when the choice to skip
+ * such a range is actually made.  lazy_scan_heap passes the
+ * vacrel->skippedallvis flag, making everything safe; lazy_scan_prefetch only
+ * looks ahead, and passes a flag of its own.)
  */
 static BlockNumber
 lazy_scan_skip(LVRelState *vacrel, Buffer *vmbuffer, BlockNumber next_block,
-			   bool *next_unskippable_allvis, bool *skipping_current_range)
+			   bool *next_unskippable_allvis, bool *skipping_current_range,
+			   bool *skippedallvis)
 {
 	BlockNumber rel_pages = vacrel->rel_pages,
 				next_unskippable_block = next_block,
@@ -1378,12 +1473,86 @@ lazy_scan_skip(LVRelState *vacrel, Buffer *vmbuffer, BlockNumber next_block,
 	{
 		*skipping_current_range = true;
 		if (skipsallvis)
-			vacrel->skippedallvis = true;
+			*skippedallvis = true;
 	}
 
 	return next_unskippable_block;
 }
 
+/*
+ *	lazy_scan_prefetch() -- prefetch upcoming pages for lazy_scan_heap.
+ *
+ * Called for each page that lazy_scan_heap is about to scan, after
+ * lazy_scan_skip has set up the range following that page.  We keep up to
+ * prefetch_maximum of the pages that will actually be scanned after blkno
+ * requested ahead of the scan.  To find them, the prefetch cursor walks
+ * forward through the visibility map making the same lazy_scan_skip
+ * decisions that lazy_scan_heap will make when it gets there, so the window
+ * extends past any number of skipped ranges and short unskipped runs, and
+ * covers a short tail of all-visible pages that will be read anyway.
+ *
+ * The cursor's decisions can disagree with the scan's when the visibility map
+ * changes in between; that only costs a wasted or missed prefetch.  If the
+ * scan ever overtakes the cursor, we simply restart it from the scan's state.
+ *
+ * Kernel readahead already covers runs of consecutive pages, but it cannot
+ * anticipate the jump over a skipped range, nor does it help much when the
+ * pages to scan are scattered among all-visible pages.
+ */
+static void
+lazy_scan_prefetch(LVRelState *vacrel, BlockNumber blkno,
+				   BlockNumber next_unskippable_block,
+				   bool skipping_current_range,
+				   LVPrefetchState *prefetch)
+{
+#ifdef USE_PREFETCH
+	if (vacrel->prefetch_maximum <= 0)
+		return;
+
+	if (blkno >= prefetch->next_block)
+	{
+		/* First call, or the scan overtook the cursor: restart from here */
+		prefetch->next_block = blkno + 1;
+		prefetch->next_unskippable_block = next_unskippable_block;
+		prefetch->skipping_current_range = skipping_current_range;
+		prefetch->pages_ahead = 0;
+	}
+	else if (prefetch->pages_ahead > 0)
+	{
+		/* blkno was prefetched earlier, and is no longer ahead of the scan */
+		prefetch->pages_ahead--;
+	}
+
+	while (prefetch->pages_ahead < vacrel->prefetch_maximum &&
+		   prefetch->next_block < vacrel->rel_pages)
+	{
+		BlockNumber pblkno = prefetch->next_block;
+
+		if (pblkno == prefetch->next_unskippable_block)
+		{
+			bool		next_unskippable_allvis;
+			bool		skippedallvis = false;
+
+			prefetch->next_unskippable_block =
+				lazy_scan_skip(vacrel, &prefetch->vmbuffer, pblkno + 1,
+							   &next_unskippable_allvis,
+							   &prefetch->skipping_current_range,
+							   &skippedallvis);
+		}
+		else if (prefetch->skipping_current_range)
+		{
+			/* lazy_scan_heap won't read the rest of this range */
+			prefetch->next_block = prefetch->next_unskippable_block;
+			continue;
+		}
+
+		PrefetchBuffer(vacrel->rel, MAIN_FORKNUM, pblkno);
+		prefetch->pages_ahead++;
+		prefetch->next_block = pblkno + 1;
+	}
+#endif							/* USE_PREFETCH */
+}
+
 /*
  *	lazy_scan_new_or_empty() -- lazy_scan_heap() new/empty page handling.
  *
@@ -1558,9 +1727,25 @@ lazy_scan_prune(LVRelState *vacrel,
 	MultiXactId NewRelminMxid;
 	OffsetNumber deadoffsets[MaxHeapTuplesPerPage];
 	xl_heap_freeze_tuple frozen[MaxHeapTuplesPerPage];
+	bool		page_is_cold;
+	bool		try_eager_freeze;
+	bool		eager_all_frozen;
+	int			neagerfrozen;
+	TransactionId EagerRelfrozenXid;
+	MultiXactId EagerRelminMxid;
+	xl_heap_freeze_tuple eager_frozen[MaxHeapTuplesPerPage];
+	xl_heap_freeze_tuple *freeze_plans;
+	TransactionId freeze_cutoff;
 
 	Assert(BufferGetBlockNumber(buf) == blkno);
 
+	/*
+	 * Determine if the page is a candidate for eager freezing.  This has to
+	 * look at the page LSN before heap_page_prune() has a chance to advance
+	 * it: pruning the page doesn't make it any less cold.
+	 */
+	page_is_cold = PageGetLSN(page) < vacrel->EagerFreezeLSN;
+
 	/*
 	 * maxoff might be reduced following line pointer array truncation in
 	 * heap_page_prune.  That's safe for us to ignore, since the reclaimed
@@ -1577,6 +1762,11 @@ retry:
 	lpdead_items = 0;
 	live_tuples = 0;
 	recently_dead_tuples = 0;
+	try_eager_freeze = page_is_cold;
+	eager_all_frozen = true;
+	neagerfrozen = 0;
+	EagerRelfrozenXid = NewRelfrozenXid;
+	EagerRelminMxid = NewRelminMxid;
 
 	/*
 	 * Prune all HOT-update chains in this page.
@@ -1792,10 +1982,66 @@ retry:
 		 */
 		if (!tuple_totally_frozen)
 			prunestate->all_frozen = false;
+
+		/*
+		 * Also prepare to freeze the tuple eagerly, in case we decide to do
+		 * that for the whole page below.  That only happens when the page
+		 * will be all-visible, so give up as soon as it's clear it won't be.
+		 * Any XID that is all-visible precedes OldestXmin, so OldestXmin is
+		 * safe to use as the cutoff here.
+		 *
+		 * Don't freeze eagerly if xmax is a MultiXactId, though.  With the
+		 * later cutoff, FreezeMultiXactId might have to create a new multi
+		 * to replace it, and we'd pay for that even when the eager plans end
+		 * up unused.  Such pages are left to the regular cutoffs.
+		 */
+		if (try_eager_freeze &&
+			(!prunestate->all_visible ||
+			 (tuple.t_data->t_infomask & HEAP_XMAX_IS_MULTI) != 0))
+			try_eager_freeze = false;
+		if (try_eager_freeze)
+		{
+			bool		eager_totally_frozen;
+
+			if (heap_prepare_freeze_tuple(tuple.t_data,
+										  vacrel->relfrozenxid,
+										  vacrel->relminmxid,
+										  vacrel->OldestXmin,
+										  vacrel->MultiXactCutoff,
+										  &eager_frozen[neagerfrozen],
+										  &eager_totally_frozen,
+										  &EagerRelfrozenXid,
+										  &EagerRelminMxid))
+				eager_frozen[neagerfrozen++].offset = offnum;
+
+			if (!eager_totally_frozen)
+				eager_all_frozen = false;
+		}
 	}
 
 	vacrel->offnum = InvalidOffsetNumber;
 
+	/*
+	 * Use the eager freeze plans instead of the regular ones if they make an
+	 * all-visible page all-frozen that otherwise wouldn't be.  There's no
+	 * point in paying for the extra WAL when the page won't be set
+	 * all-frozen in the visibility map anyway.
+	 */
+	freeze_plans = frozen;
+	freeze_cutoff = vacrel->FreezeLimit;
+	if (try_eager_freeze && prunestate->all_visible &&
+		!prunestate->all_frozen && eager_all_frozen)
+	{
+		Assert(neagerfrozen >= nfrozen);
+		freeze_plans = eager_frozen;
+		nfrozen = neagerfrozen;
+		freeze_cutoff = vacrel->OldestXmin;
+		NewRelfrozenXid = EagerRelfrozenXid;
+		NewRelminMxid = EagerRelminMxid;
+		prunestate->all_frozen = true;
+		vacrel->eager_frozen_pages++;
+	}
+
 	/*
 	 * We have now divided every item on the page into either an LP_DEAD item
 	 * that will need to be vacuumed in indexes later, or a LP_NORMAL tuple
@@ -1830,23 +2076,30 @@ retry:
 		{
 			HeapTupleHeader htup;
 
-			itemid = PageGetItemId(page, frozen[i].offset);
+			itemid = PageGetItemId(page, freeze_plans[i].offset);
 			htup = (HeapTupleHeader) PageGetItem(page, itemid);
 
-			heap_execute_freeze_tuple(htup, &frozen[i]);
+			heap_execute_freeze_tuple(htup, &freeze_plans[i]);
 		}
 
 		/* Now WAL-log freezing if necessary */
 		if (RelationNeedsWAL(vacrel->rel))
 		{
 			XLogRecPtr	recptr;
+			uint64		wal_bytes_before = pgWalUsage.wal_bytes;
 
-			recptr = log_heap_freeze(vacrel->rel, buf, vacrel->FreezeLimit,
-									 frozen, nfrozen);
+			recptr = log_heap_freeze(vacrel->rel, buf, freeze_cutoff,
+									 freeze_plans, nfrozen);
 			PageSetLSN(page, recptr);
+
+			vacrel->freeze_wal_records++;
+			vacrel->freeze_wal_bytes += pgWalUsage.wal_bytes - wal_bytes_before;
 		}
 
 		END_CRIT_SECTION();
+
+		vacrel->frozen_pages++;
+		vacrel->tuples_frozen += nfrozen;
 	}
 
 	/*
@@ -2399,6 +2652,10 @@ lazy_vacuum_heap_rel(LVRelState *vacrel)
 	BlockNumber vacuumed_pages;
 	Buffer		vmbuffer = InvalidBuffer;
 	LVSavedErrInfo saved_err_info;
+#ifdef USE_PREFETCH
+	int			prefetch_index = 0;
+	int			prefetch_pages = 0;
+#endif
 
 	Assert(vacrel->do_index_vacuuming);
 	Assert(vacrel->do_index_cleanup);
@@ -2425,6 +2682,32 @@ lazy_vacuum_heap_rel(LVRelState *vacrel)
 
 		vacuum_delay_point();
 
+#ifdef USE_PREFETCH
+
+		/*
+		 * The pages we need to visit are known in advance (they're the
+		 * distinct block numbers in dead_items, in order), so keep up to
+		 * prefetch_maximum of them in flight ahead of the page being
+		 * vacuumed.  Unlike the first heap pass, these are typically
+		 * scattered throughout the table, so kernel readahead is of little
+		 * use here.
+		 */
+		while (prefetch_pages < vacrel->prefetch_maximum &&
+			   prefetch_index < vacrel->dead_items->num_items)
+		{
+			BlockNumber pblk;
+
+			pblk = ItemPointerGetBlockNumber(&vacrel->dead_items->items[prefetch_index]);
+			PrefetchBuffer(vacrel->rel, MAIN_FORKNUM, pblk);
+			prefetch_pages++;
+
+			/* Advance past all TIDs on the page we just prefetched */
+			while (prefetch_index < vacrel->dead_items->num_items &&
+				   ItemPointerGetBlockNumber(&vacrel->dead_items->items[prefetch_index]) == pblk)
+				prefetch_index++;
+		}
+#endif
+
 		tblk = ItemPointerGetBlockNumber(&vacrel->dead_items->items[index]);
 		vacrel->blkno = tblk;
 		buf = ReadBufferExtended(vacrel->rel, MAIN_FORKNUM, tblk, RBM_NORMAL,
@@ -2439,6 +2722,10 @@ lazy_vacuum_heap_rel(LVRelState *vacrel)
 		UnlockReleaseBuffer(buf);
 		RecordPageWithFreeSpace(vacrel->rel, tblk, freespace);
 		vacuumed_pages++;
+#ifdef USE_PREFETCH
+		if (prefetch_pages > 0)
+			prefetch_pages--;
+#endif
 	}
 
 	/* Clear the block number information */
@@ -3114,7 +3401,7 @@ dead_items_max_items(LVRelState *vacrel)
 
 		max_items = MAXDEADITEMS(vac_work_mem * 1024L);
 		max_items = Min(max_items, INT_MAX);
-		max_items = Min(max_items, MAXDEADITEMS(MaxAllocSize));
+		max_items = Min(max_items, MAXDEADITEMS(MaxAllocHugeSize));
 
 		/* curious coding here to ensure the multiplication can't overflow */
 		if ((BlockNumber) (max_items / MaxHeapTuplesPerPage) > rel_pages)
@@ -3186,7 +3473,9 @@ dead_items_alloc(LVRelState *vacrel, int nworkers)
 	}
 
 	/* Serial VACUUM case */
-	dead_items = (VacDeadItems *) palloc(vac_max_items_to_alloc_size(max_items));
+	dead_items = (VacDeadItems *)
+		MemoryContextAllocHuge(CurrentMemoryContext,
+							   vac_max_items_to_alloc_size(max_items));
 	dead_items->max_items = max_items;
 	dead_items->num_items = 0;
 
@@ -369,6 +369,11 @@ btbeginscan(Relation rel, int nkeys, int norderbys)
 	so->killedItems = NULL;		/* until needed */
 	so->numKilled = 0;
 
+	so->skipKey = NULL;
+	so->skipPending = false;
+	so->skipNextGroup = false;
+	so->skipTuple = NULL;		/* until needed */
+
 	/*
 	 * We don't know yet whether the scan will be index-only, so we do not
 	 * allocate the tuple workspace arrays until btrescan.  However, we set up
@@ -404,6 +409,8 @@ btrescan(IndexScanDesc scan, ScanKey scankey, int nscankeys,
 
 	so->markItemIndex = -1;
 	so->arrayKeyCount = 0;
+	so->skipKey = NULL;
+	so->skipPending = false;
 	BTScanPosUnpinIfPinned(so->markPos);
 	BTScanPosInvalidate(so->markPos);
 
@@ -472,6 +479,8 @@ btendscan(IndexScanDesc scan)
 		MemoryContextDelete(so->arrayContext);
 	if (so->killedItems != NULL)
 		pfree(so->killedItems);
+	if (so->skipTuple != NULL)
+		pfree(so->skipTuple);
 	if (so->currTuples != NULL)
 		pfree(so->currTuples);
 	/* so->markTuples should not be pfree'd, see btrescan */
@@ -547,6 +556,9 @@ btrestrpos(IndexScanDesc scan)
 			BTScanPosUnpinIfPinned(so->currPos);
 		}
 
+		/* Any pending skip was decided by a page we're now leaving */
+		so->skipPending = false;
+
 		if (BTScanPosIsValid(so->markPos))
 		{
 			/* bump pin on mark buffer for assignment to current buffer */
@@ -26,6 +26,9 @@
 
 static void _bt_drop_lock_and_maybe_pin(IndexScanDesc scan, BTScanPos sp);
 static OffsetNumber _bt_binsrch(Relation rel, BTScanInsert key, Buffer buf);
+static inline int32 _bt_compare_skip(Relation rel, BTScanInsert key,
+									 Page page, OffsetNumber offnum,
+									 int skipatts, int *nequalatts);
 static int	_bt_binsrch_posting(BTScanInsert key, Page page,
 								OffsetNumber offnum);
 static bool _bt_readpage(IndexScanDesc scan, ScanDirection dir,
@@ -44,6 +47,9 @@ static bool _bt_parallel_readpage(IndexScanDesc scan, BlockNumber blkno,
 								  ScanDirection dir);
 static Buffer _bt_walk_left(Relation rel, Buffer buf, Snapshot snapshot);
 static bool _bt_endpoint(IndexScanDesc scan, ScanDirection dir);
+static void _bt_skip_check(IndexScanDesc scan, Page page,
+						   OffsetNumber minoff, OffsetNumber maxoff);
+static OffsetNumber _bt_skip_descend(IndexScanDesc scan);
 static inline void _bt_initialize_more_data(BTScanOpaque so, ScanDirection dir);
 
 
@@ -346,6 +352,9 @@ _bt_binsrch(Relation rel,
 	int32		result,
 				cmpval;
 
+	int			lowequal,
+				highequal;
+
 	page = BufferGetPage(buf);
 	opaque = BTPageGetOpaque(page);
 
@@ -378,23 +387,42 @@ _bt_binsrch(Relation rel,
 	 * 'low' are <= scan key, all slots at or after 'high' are > scan key.
 	 *
 	 * We can fall out when high == low.
+	 *
+	 * We also keep track of how many leading key attributes of the scan key
+	 * were found to be equal to the tuples just before 'low' (lowequal) and
+	 * at 'high' (highequal).  Every tuple in between must have the same
+	 * values for the leading attributes that both bounds share with the scan
+	 * key, so _bt_compare_skip needn't compare those again.  This helps most
+	 * with multi-column indexes whose leading columns have few distinct
+	 * values, or are expensive to compare (text with a non-C collation, for
+	 * example).
 	 */
 	high++;						/* establish the loop invariant for high */
 
 	cmpval = key->nextkey ? 0 : 1;	/* select comparison value */
+	lowequal = highequal = 0;
 
 	while (high > low)
 	{
 		OffsetNumber mid = low + ((high - low) / 2);
+		int			nequal;
 
 		/* We have low <= mid < high, so mid points at a real slot */
 
-		result = _bt_compare(rel, key, page, mid);
+		result = _bt_compare_skip(rel, key, page, mid,
+								  Min(lowequal, highequal), &nequal);
+		Assert(result == _bt_compare(rel, key, page, mid));
 
 		if (result >= cmpval)
+		{
 			low = mid + 1;
+			lowequal = nequal;
+		}
 		else
+		{
 			high = mid;
+			highequal = nequal;
+		}
 	}
 
 	/*
@@ -657,6 +685,28 @@ _bt_compare(Relation rel,
 			BTScanInsert key,
 			Page page,
 			OffsetNumber offnum)
+{
+	int			nequalatts;
+
+	return _bt_compare_skip(rel, key, page, offnum, 0, &nequalatts);
+}
+
+/*
+ *	_bt_compare_skip() -- _bt_compare(), skipping known-equal attributes
+ *
+ * Caller asserts that the first skipatts key attributes of the tuple at
+ * offnum are equal to those of the scan key, so we start comparing at the
+ * next attribute.  *nequalatts is set to the number of leading key
+ * attributes found (or known) to be equal, which callers doing a binary
+ * search can use to derive skipatts for their next probe.
+ */
+static inline int32
+_bt_compare_skip(Relation rel,
+				 BTScanInsert key,
+				 Page page,
+				 OffsetNumber offnum,
+				 int skipatts,
+				 int *nequalatts)
 {
 	TupleDesc	itupdesc = RelationGetDescr(rel);
 	BTPageOpaque opaque = BTPageGetOpaque(page);
@@ -676,7 +726,10 @@ _bt_compare(Relation rel,
 	 * --- see NOTE above.
 	 */
 	if (!P_ISLEAF(opaque) && offnum == P_FIRSTDATAKEY(opaque))
+	{
+		*nequalatts = 0;
 		return 1;
+	}
 
 	itup = (IndexTuple) PageGetItem(page, PageGetItemId(page, offnum));
 	ntupatts = BTreeTupleGetNAtts(itup, rel);
@@ -696,8 +749,9 @@ _bt_compare(Relation rel,
 	ncmpkey = Min(ntupatts, key->keysz);
 	Assert(key->heapkeyspace || ncmpkey == key->keysz);
 	Assert(!BTreeTupleIsPosting(itup) || key->allequalimage);
-	scankey = key->scankeys;
-	for (int i = 1; i <= ncmpkey; i++)
+	Assert(skipatts >= 0 && skipatts <= ncmpkey);
+	scankey = key->scankeys + skipatts;
+	for (int i = skipatts + 1; i <= ncmpkey; i++)
 	{
 		Datum		datum;
 		bool		isNull;
@@ -741,11 +795,16 @@ _bt_compare(Relation rel,
 
 		/* if the keys are unequal, return the difference */
 		if (result != 0)
+		{
+			*nequalatts = i - 1;
 			return result;
+		}
 
 		scankey++;
 	}
 
+	*nequalatts = ncmpkey;
+
 	/*
 	 * All non-truncated attributes (other than heap TID) were found to be
 	 * equal.  Treat truncated attributes as minus infinity when scankey has a
@@ -898,6 +957,9 @@ _bt_first(IndexScanDesc scan, ScanDirection dir)
 		return false;
 	}
 
+	/* See if the scan can skip over parts of leading column groups */
+	_bt_skip_prepare(scan);
+
 	/*
 	 * For parallel scans, get the starting page from shared state. If the
 	 * scan has not started, proceed to find out first leaf page in the usual
@@ -1575,6 +1637,9 @@ _bt_readpage(IndexScanDesc scan, ScanDirection dir, OffsetNumber offnum)
 	/* initialize tuple workspace to empty */
 	so->currPos.nextTupleOffset = 0;
 
+	/* no skip decided for this page yet */
+	so->skipPending = false;
+
 	/*
 	 * Now that the current page has been made consistent, the macro should be
 	 * good.
@@ -1667,6 +1732,8 @@ _bt_readpage(IndexScanDesc scan, ScanDirection dir, OffsetNumber offnum)
 
 		if (!continuescan)
 			so->currPos.moreRight = false;
+		else if (so->skipKey != NULL && !P_RIGHTMOST(opaque))
+			_bt_skip_check(scan, page, minoff, maxoff);
 
 		Assert(itemIndex <= MaxTIDsPerBTreePage);
 		so->currPos.firstItem = 0;
@@ -1983,6 +2050,7 @@ _bt_readnextpage(IndexScanDesc scan, BlockNumber blkno, ScanDirection dir)
 	Relation	rel;
 	Page		page;
 	BTPageOpaque opaque;
+	OffsetNumber offnum;
 	bool		status;
 
 	rel = scan->indexRelation;
@@ -2003,18 +2071,30 @@ _bt_readnextpage(IndexScanDesc scan, BlockNumber blkno, ScanDirection dir)
 			}
 			/* check for interrupts while we're not holding any buffer lock */
 			CHECK_FOR_INTERRUPTS();
-			/* step right one page */
-			so->currPos.buf = _bt_getbuf(rel, blkno, BT_READ);
-			page = BufferGetPage(so->currPos.buf);
-			TestForOldSnapshot(scan->xs_snapshot, rel, page);
-			opaque = BTPageGetOpaque(page);
+			if (so->skipPending)
+			{
+				/* descend to where the next matches could be */
+				offnum = _bt_skip_descend(scan);
+				blkno = BufferGetBlockNumber(so->currPos.buf);
+				page = BufferGetPage(so->currPos.buf);
+				opaque = BTPageGetOpaque(page);
+			}
+			else
+			{
+				/* step right one page */
+				so->currPos.buf = _bt_getbuf(rel, blkno, BT_READ);
+				page = BufferGetPage(so->currPos.buf);
+				TestForOldSnapshot(scan->xs_snapshot, rel, page);
+				opaque = BTPageGetOpaque(page);
+				offnum = P_FIRSTDATAKEY(opaque);
+			}
 			/* check for deleted page */
 			if (!P_IGNORE(opaque))
 			{
 				PredicateLockPage(rel, blkno, scan->xs_snapshot);
 				/* see if there are any matches on this page */
 				/* note that this will clear moreRight if we can stop */
-				if (_bt_readpage(scan, dir, P_FIRSTDATAKEY(opaque)))
+				if (_bt_readpage(scan, dir, offnum))
 					break;
 			}
 			else if (scan->parallel_scan != NULL)
@@ -2473,6 +2553,128 @@ _bt_endpoint(IndexScanDesc scan, ScanDirection dir)
 	return true;
 }
 
+/*
+ *	_bt_skip_check() -- Decide whether to skip the pages to the right
+ *
+ * Called by _bt_readpage for a forward scan that _bt_skip_prepare found
+ * eligible for skipping, once the page has been read and the scan is to
+ * continue to the right.  We only skip when every item on the page shares
+ * the high key's leading column value, which suggests a group that spans
+ * many pages; otherwise the descent would likely cost more than simply
+ * stepping right.
+ *
+ * If the high key's second column is already past the scan key's value,
+ * none of the rest of the group can match, so the scan resumes at the next
+ * leading column value.  If it is still before the scan key's value, the
+ * scan resumes at the first tuple of the group that can match.
+ */
+static void
+_bt_skip_check(IndexScanDesc scan, Page page,
+			   OffsetNumber minoff, OffsetNumber maxoff)
+{
+	BTScanOpaque so = (BTScanOpaque) scan->opaque;
+	Relation	rel = scan->indexRelation;
+	TupleDesc	itupdesc = RelationGetDescr(rel);
+	IndexTuple	hikey;
+	IndexTuple	firstitup;
+	Datum		hidatum;
+	Datum		firstdatum;
+	bool		hinull;
+	bool		firstnull;
+	int32		result;
+
+	if (minoff > maxoff)
+		return;
+
+	hikey = (IndexTuple) PageGetItem(page, PageGetItemId(page, P_HIKEY));
+	firstitup = (IndexTuple) PageGetItem(page, PageGetItemId(page, minoff));
+	if (BTreeTupleGetNAtts(hikey, rel) < 2)
+		return;
+
+	/* Is the whole page within the high key's leading column group? */
+	hidatum = index_getattr(hikey, 1, itupdesc, &hinull);
+	firstdatum = index_getattr(firstitup, 1, itupdesc, &firstnull);
+	if (hinull || firstnull)
+		return;
+	result = DatumGetInt32(FunctionCall2Coll(index_getprocinfo(rel, 1,
+															   BTORDER_PROC),
+											 rel->rd_indcollation[0],
+											 firstdatum, hidatum));
+	if (result != 0)
+		return;
+
+	/* Compare the high key's second column with the scan key */
+	hidatum = index_getattr(hikey, 2, itupdesc, &hinull);
+	if (hinull)
+		return;
+	result = DatumGetInt32(FunctionCall2Coll(index_getprocinfo(rel, 2,
+															   BTORDER_PROC),
+											 rel->rd_indcollation[1],
+											 hidatum,
+											 so->skipKey->sk_argument));
+	if (so->skipKey->sk_flags & SK_BT_DESC)
+		INVERT_COMPARE_RESULT(result);
+	if (result == 0)
+		return;
+
+	so->skipPending = true;
+	so->skipNextGroup = (result > 0);
+	memcpy(so->skipTuple, hikey, IndexTupleSize(hikey));
+}
+
+/*
+ *	_bt_skip_descend() -- Descend to the target of a pending skip
+ *
+ * Builds an insertion scan key from the high key saved by _bt_skip_check and
+ * searches the tree with it.  On return so->currPos.buf is pinned and
+ * read-locked, and we return the offset at which to start reading it.  The
+ * target always lies at or beyond the right sibling of the page that saved
+ * the high key, so the scan never revisits an item.
+ */
+static OffsetNumber
+_bt_skip_descend(IndexScanDesc scan)
+{
+	BTScanOpaque so = (BTScanOpaque) scan->opaque;
+	Relation	rel = scan->indexRelation;
+	BTScanInsert inskey;
+	BTStack		stack;
+	Buffer		buf;
+	OffsetNumber offnum;
+
+	Assert(so->skipPending && so->skipKey != NULL);
+
+	inskey = _bt_mkscankey(rel, so->skipTuple);
+	inskey->scantid = NULL;
+	if (so->skipNextGroup)
+	{
+		/* first item > high key's leading column value */
+		inskey->keysz = 1;
+		inskey->nextkey = true;
+	}
+	else
+	{
+		/* first item >= (high key's leading column value, scan key value) */
+		inskey->keysz = 2;
+		inskey->nextkey = false;
+		inskey->scankeys[1].sk_argument = so->skipKey->sk_argument;
+		inskey->scankeys[1].sk_flags &= ~SK_ISNULL;
+	}
+	so->skipPending = false;
+
+	stack = _bt_search(rel, inskey, &buf, BT_READ, scan->xs_snapshot);
+	_bt_freestack(stack);
+
+	/* the index can't have become empty while we were reading it */
+	Assert(BufferIsValid(buf));
+
+	offnum = _bt_binsrch(rel, inskey, buf);
+	pfree(inskey);
+
+	so->currPos.buf = buf;
+
+	return offnum;
+}
+
 /*
  * _bt_initialize_more_data() -- initialize moreLeft/moreRight appropriately
  * for scan direction
@@ -1012,6 +1012,64 @@ _bt_preprocess_keys(IndexScanDesc scan)
 	so->numberOfKeys = new_numberOfKeys;
 }
 
+/*
+ *	_bt_skip_prepare() -- Decide whether the scan can skip within groups
+ *
+ * A scan whose keys say nothing about the leading index column, but which
+ * has an equality key on the second column, has to read every leaf page:
+ * there is no starting boundary for _bt_first to use, and no required keys
+ * to end the scan early.  Within each group of tuples sharing a leading
+ * column value, though, the matches are contiguous.  When such a group spans
+ * several leaf pages, _bt_readpage can tell from a page's high key that the
+ * rest of the group either lies entirely beyond the match (so the scan can
+ * resume at the next leading value) or entirely before it (so the scan can
+ * resume at the matching second column value), and have the scan descend
+ * the tree to that point instead of reading the pages in between.
+ *
+ * Here we just determine whether the preprocessed scan keys allow this, and
+ * remember the second column's equality key in so->skipKey.  We only handle
+ * forward, non-parallel scans without array keys, and only when the key's
+ * comparison value has the index column's own type, so that the column's
+ * default ORDER proc can compare it against index tuples.
+ */
+void
+_bt_skip_prepare(IndexScanDesc scan)
+{
+	BTScanOpaque so = (BTScanOpaque) scan->opaque;
+	Relation	rel = scan->indexRelation;
+	int			i;
+
+	so->skipKey = NULL;
+	so->skipPending = false;
+
+	if (scan->parallel_scan != NULL || so->numArrayKeys != 0 ||
+		IndexRelationGetNumberOfKeyAttributes(rel) < 2)
+		return;
+
+	/* Preprocessed keys are in attribute order */
+	for (i = 0; i < so->numberOfKeys; i++)
+	{
+		ScanKey		cur = &so->keyData[i];
+
+		if (cur->sk_attno == 1)
+			return;
+		if (cur->sk_attno > 2)
+			break;
+		if (cur->sk_strategy == BTEqualStrategyNumber &&
+			!(cur->sk_flags & (SK_ISNULL | SK_ROW_HEADER |
+							   SK_SEARCHNULL | SK_SEARCHNOTNULL)) &&
+			(cur->sk_subtype == InvalidOid ||
+			 cur->sk_subtype == rel->rd_opcintype[1]))
+		{
+			so->skipKey = cur;
+			break;
+		}
+	}
+
+	if (so->skipKey != NULL && so->skipTuple == NULL)
+		so->skipTuple = (IndexTuple) palloc(BLCKSZ);
+}
+
 /*
  * Compare two scankey values using a specified operator.
  *
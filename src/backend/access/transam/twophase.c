@@ -106,6 +106,7 @@
 #include "storage/smgr.h"
 #include "utils/builtins.h"
 #include "utils/memutils.h"
+#include "utils/sharedplancache.h"
 #include "utils/timestamp.h"
 
 /*
@@ -1608,14 +1609,15 @@ FinishPreparedTransaction(const char *gid, bool isCommit)
 	 * Handle cache invalidation messages.
 	 *
 	 * Relcache init file invalidation requires processing both before and
-	 * after we send the SI messages, only when committing.  See
-	 * AtEOXact_Inval().
+	 * after we send the SI messages, only when committing, and so does the
+	 * shared plan cache.  See AtEOXact_Inval().
 	 */
 	if (isCommit)
 	{
 		if (hdr->initfileinval)
 			RelationCacheInitFilePreInvalidate();
 		SendSharedInvalidMessages(invalmsgs, hdr->ninvalmsgs);
+		SharedPlanCacheProcessMessages(invalmsgs, hdr->ninvalmsgs);
 		if (hdr->initfileinval)
 			RelationCacheInitFilePostInvalidate();
 	}
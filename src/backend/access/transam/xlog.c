@@ -2922,6 +2922,7 @@ XLogFileInitInternal(XLogSegNo logsegno, TimeLineID logtli,
 	XLogSegNo	installed_segno;
 	XLogSegNo	max_segno;
 	int			fd;
+	int			flags;
 	int			save_errno;
 
 	Assert(logtli != 0);
@@ -2956,7 +2957,15 @@ XLogFileInitInternal(XLogSegNo logsegno, TimeLineID logtli,
 	unlink(tmppath);
 
 	/* do not use get_sync_bit() here --- want to fsync only at end of fill */
-	fd = BasicOpenFile(tmppath, O_RDWR | O_CREAT | O_EXCL | PG_BINARY);
+	flags = O_RDWR | O_CREAT | O_EXCL | PG_BINARY;
+
+	/*
+	 * Zero-filling writes whole aligned pages, so it can bypass the kernel
+	 * cache if requested.  The single-byte write done otherwise can't.
+	 */
+	if ((io_direct_flags & IO_DIRECT_WAL_INIT) && wal_init_zero)
+		flags |= PG_O_DIRECT;
+	fd = BasicOpenFile(tmppath, flags);
 	if (fd < 0)
 		ereport(ERROR,
 				(errcode_for_file_access(),
@@ -7870,10 +7879,20 @@ static int
 get_sync_bit(int method)
 {
 	int			o_direct_flag = 0;
+	int			forced_direct_flag = 0;
+
+	/*
+	 * debug_io_direct=wal requests O_DIRECT regardless of the sync method.
+	 * WAL is written from the XLOG_BLCKSZ-aligned WAL buffers in whole pages,
+	 * which satisfies the alignment requirements.  That's not true of
+	 * walreceiver, see below.
+	 */
+	if ((io_direct_flags & IO_DIRECT_WAL) && !AmWalReceiverProcess())
+		forced_direct_flag = PG_O_DIRECT;
 
 	/* If fsync is disabled, never open in sync mode */
 	if (!enableFsync)
-		return 0;
+		return forced_direct_flag;
 
 	/*
 	 * Optimize writes by bypassing kernel cache with O_DIRECT when using
@@ -7891,6 +7910,7 @@ get_sync_bit(int method)
 	 */
 	if (!XLogIsNeeded() && !AmWalReceiverProcess())
 		o_direct_flag = PG_O_DIRECT;
+	o_direct_flag |= forced_direct_flag;
 
 	switch (method)
 	{
@@ -7903,7 +7923,7 @@ get_sync_bit(int method)
 		case SYNC_METHOD_FSYNC:
 		case SYNC_METHOD_FSYNC_WRITETHROUGH:
 		case SYNC_METHOD_FDATASYNC:
-			return 0;
+			return forced_direct_flag;
 #ifdef OPEN_SYNC_FLAG
 		case SYNC_METHOD_OPEN:
 			return OPEN_SYNC_FLAG | o_direct_flag;
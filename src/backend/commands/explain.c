@@ -1953,6 +1953,9 @@ ExplainNode(PlanState *planstate, List *ancestors,
 			if (plan->qual)
 				show_instrumentation_count("Rows Removed by Filter", 2,
 										   planstate, es);
+			if (es->analyze &&
+				castNode(NestLoopState, planstate)->nl_InnerMaterialized)
+				ExplainPropertyBool("Inner Materialized", true, es);
 			break;
 		case T_MergeJoin:
 			show_upper_qual(((MergeJoin *) plan)->mergeclauses,
@@ -906,7 +906,11 @@ DefineIndex(Oid relationId,
 	 * by putting values that ought to be unique in different partitions.
 	 *
 	 * We could lift this limitation if we had global indexes, but those have
-	 * their own problems, so this is a useful feature combination.
+	 * their own problems, so this is a useful feature combination.  (A
+	 * global index would need index tuples that identify the partition as
+	 * well as the TID, uniqueness checks that look across partitions,
+	 * cleanup on DETACH/DROP PARTITION, and a VACUUM that can tell which of
+	 * its entries point into the partition being vacuumed.)
 	 */
 	if (partitioned && (stmt->unique || stmt->primary))
 	{
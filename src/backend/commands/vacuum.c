@@ -69,6 +69,7 @@ int			vacuum_multixact_freeze_min_age;
 int			vacuum_multixact_freeze_table_age;
 int			vacuum_failsafe_age;
 int			vacuum_multixact_failsafe_age;
+int			vacuum_eager_freeze_wal_age;
 
 
 /* A few variables that don't seem worth passing around as parameters */
@@ -95,7 +96,6 @@ static bool vacuum_rel(Oid relid, RangeVar *relation, VacuumParams *params);
 static double compute_parallel_delay(void);
 static VacOptValue get_vacoptval_from_boolean(DefElem *def);
 static bool vac_tid_reaped(ItemPointer itemptr, void *state);
-static int	vac_cmp_itemptr(const void *left, const void *right);
 
 /*
  * Primary entry point for manual VACUUM and ANALYZE commands
@@ -2371,7 +2371,7 @@ vac_cleanup_one_index(IndexVacuumInfo *ivinfo, IndexBulkDeleteResult *istat)
 Size
 vac_max_items_to_alloc_size(int max_items)
 {
-	Assert(max_items <= MAXDEADITEMS(MaxAllocSize));
+	Assert(max_items <= MAXDEADITEMS(MaxAllocHugeSize));
 
 	return offsetof(VacDeadItems, items) + sizeof(ItemPointerData) * max_items;
 }
@@ -2390,56 +2390,44 @@ vac_tid_reaped(ItemPointer itemptr, void *state)
 	int64		litem,
 				ritem,
 				item;
-	ItemPointer res;
+	ItemPointer items = dead_items->items;
+	size_t		lo,
+				hi;
 
-	litem = itemptr_encode(&dead_items->items[0]);
-	ritem = itemptr_encode(&dead_items->items[dead_items->num_items - 1]);
+	litem = itemptr_encode(&items[0]);
+	ritem = itemptr_encode(&items[dead_items->num_items - 1]);
 	item = itemptr_encode(itemptr);
 
 	/*
-	 * Doing a simple bound check before bsearch() is useful to avoid the
-	 * extra cost of bsearch(), especially if dead items on the heap are
+	 * Doing a simple bound check before searching is useful to avoid the
+	 * extra cost of the search, especially if dead items on the heap are
 	 * concentrated in a certain range.  Since this function is called for
 	 * every index tuple, it pays to be really fast.
 	 */
 	if (item < litem || item > ritem)
 		return false;
 
-	res = (ItemPointer) bsearch((void *) itemptr,
-								(void *) dead_items->items,
-								dead_items->num_items,
-								sizeof(ItemPointerData),
-								vac_cmp_itemptr);
-
-	return (res != NULL);
-}
-
-/*
- * Comparator routines for use with qsort() and bsearch().
- */
-static int
-vac_cmp_itemptr(const void *left, const void *right)
-{
-	BlockNumber lblk,
-				rblk;
-	OffsetNumber loff,
-				roff;
-
-	lblk = ItemPointerGetBlockNumber((ItemPointer) left);
-	rblk = ItemPointerGetBlockNumber((ItemPointer) right);
-
-	if (lblk < rblk)
-		return -1;
-	if (lblk > rblk)
-		return 1;
-
-	loff = ItemPointerGetOffsetNumber((ItemPointer) left);
-	roff = ItemPointerGetOffsetNumber((ItemPointer) right);
+	/*
+	 * Binary search over the encoded TIDs.  This is open-coded rather than
+	 * using bsearch() so that each probe is a single integer comparison
+	 * instead of an indirect call to a comparator.  The array can hold
+	 * hundreds of millions of TIDs when maintenance_work_mem is large, and
+	 * this is executed once per index tuple for every index.
+	 */
+	lo = 0;
+	hi = dead_items->num_items;
+	while (lo < hi)
+	{
+		size_t		mid = lo + (hi - lo) / 2;
+		int64		midval = itemptr_encode(&items[mid]);
 
-	if (loff < roff)
-		return -1;
-	if (loff > roff)
-		return 1;
+		if (midval < item)
+			lo = mid + 1;
+		else if (midval > item)
+			hi = mid;
+		else
+			return true;
+	}
 
-	return 0;
+	return false;
 }
@@ -184,7 +184,9 @@ static char *ExecBuildSlotPartitionKeyDescription(Relation rel,
 												  int maxfieldlen);
 static List *adjust_partition_colnos(List *colnos, ResultRelInfo *leaf_part_rri);
 static List *adjust_partition_colnos_using_map(List *colnos, AttrMap *attrMap);
-static PartitionPruneState *CreatePartitionPruneState(PlanState *planstate,
+static PartitionPruneState *CreatePartitionPruneState(EState *estate,
+													  PlanState *planstate,
+													  ExprContext *econtext,
 													  PartitionPruneInfo *pruneinfo);
 static void InitPartitionPruneContext(PartitionPruneContext *context,
 									  List *pruning_steps,
@@ -1332,18 +1334,35 @@ FormPartitionKeyDatum(PartitionDispatch pd,
 		elog(ERROR, "wrong number of partition key expressions");
 }
 
+/*
+ * The number of times the same partition must be found in a row before we
+ * switch from a binary search for the given values to just checking if the
+ * values belong to the last found partition.  This must be above 0.
+ */
+#define PARTITION_CACHED_FIND_THRESHOLD			16
+
 /*
  * get_partition_for_tuple
  *		Finds partition of relation which accepts the partition key specified
  *		in values and isnull
  *
+ * Bulk loads into list or range partitioned tables often send long runs of
+ * consecutive tuples to the same partition, for example when the data is
+ * ordered by a timestamp partition key.  So once we have found the same
+ * partition PARTITION_CACHED_FIND_THRESHOLD times in a row, we first check
+ * whether the tuple belongs to that partition, which costs one or two
+ * comparisons, before falling back to a binary search over all the bounds.
+ * The cache lives in the PartitionDesc.  A failed check costs those extra
+ * comparisons, and also resets the counter, so workloads that don't benefit
+ * quickly stop trying.
+ *
  * Return value is index of the partition (>= 0 and < partdesc->nparts) if one
  * found or -1 if none found.
  */
 static int
 get_partition_for_tuple(PartitionDispatch pd, Datum *values, bool *isnull)
 {
-	int			bound_offset;
+	int			bound_offset = -1;
 	int			part_index = -1;
 	PartitionKey key = pd->key;
 	PartitionDesc partdesc = pd->partdesc;
@@ -1356,25 +1375,46 @@ get_partition_for_tuple(PartitionDispatch pd, Datum *values, bool *isnull)
 			{
 				uint64		rowHash;
 
+				/* hash partitioning is too cheap to bother caching */
 				rowHash = compute_partition_hash_value(key->partnatts,
 													   key->partsupfunc,
 													   key->partcollation,
 													   values, isnull);
 
 				part_index = boundinfo->indexes[rowHash % boundinfo->nindexes];
+				if (part_index < 0)
+					part_index = boundinfo->default_index;
+				return part_index;
 			}
-			break;
 
 		case PARTITION_STRATEGY_LIST:
 			if (isnull[0])
 			{
+				/* this is far from the common case, so don't cache it */
 				if (partition_bound_accepts_nulls(boundinfo))
-					part_index = boundinfo->null_index;
+					return boundinfo->null_index;
+				return boundinfo->default_index;
 			}
 			else
 			{
 				bool		equal = false;
 
+				if (partdesc->last_found_count >= PARTITION_CACHED_FIND_THRESHOLD)
+				{
+					int			last_datum_offset = partdesc->last_found_datum_index;
+					Datum		lastDatum = boundinfo->datums[last_datum_offset][0];
+					int32		cmpval;
+
+					cmpval = DatumGetInt32(FunctionCall2Coll(&key->partsupfunc[0],
+															 key->partcollation[0],
+															 lastDatum,
+															 values[0]));
+					if (cmpval == 0)
+						return boundinfo->indexes[last_datum_offset];
+
+					/* fall through and do a binary search */
+				}
+
 				bound_offset = partition_list_bsearch(key->partsupfunc,
 													  key->partcollation,
 													  boundinfo,
@@ -1405,6 +1445,44 @@ get_partition_for_tuple(PartitionDispatch pd, Datum *values, bool *isnull)
 
 				if (!range_partkey_has_null)
 				{
+					if (partdesc->last_found_count >= PARTITION_CACHED_FIND_THRESHOLD)
+					{
+						int			last_datum_offset = partdesc->last_found_datum_index;
+						Datum	   *lastDatums = boundinfo->datums[last_datum_offset];
+						PartitionRangeDatumKind *kind = boundinfo->kind[last_datum_offset];
+						int32		cmpval;
+
+						/* Is the tuple at or above the lower bound? */
+						cmpval = partition_rbound_datum_cmp(key->partsupfunc,
+															key->partcollation,
+															lastDatums,
+															kind,
+															values,
+															key->partnatts);
+
+						/* If it's equal, no need to look at the upper bound */
+						if (cmpval == 0)
+							return boundinfo->indexes[last_datum_offset + 1];
+
+						if (cmpval < 0 && last_datum_offset + 1 < boundinfo->ndatums)
+						{
+							/* Is it below the upper bound? */
+							lastDatums = boundinfo->datums[last_datum_offset + 1];
+							kind = boundinfo->kind[last_datum_offset + 1];
+							cmpval = partition_rbound_datum_cmp(key->partsupfunc,
+																key->partcollation,
+																lastDatums,
+																kind,
+																values,
+																key->partnatts);
+
+							if (cmpval > 0)
+								return boundinfo->indexes[last_datum_offset + 1];
+						}
+
+						/* fall through and do a binary search */
+					}
+
 					bound_offset = partition_range_datum_bsearch(key->partsupfunc,
 																 key->partcollation,
 																 boundinfo,
@@ -1430,10 +1508,28 @@ get_partition_for_tuple(PartitionDispatch pd, Datum *values, bool *isnull)
 
 	/*
 	 * part_index < 0 means we failed to find a partition of this parent. Use
-	 * the default partition, if there is one.
+	 * the default partition, if there is one.  We don't cache that; the
+	 * checks above only know how to recognize partitions with bounds.
 	 */
 	if (part_index < 0)
-		part_index = boundinfo->default_index;
+		return boundinfo->default_index;
+
+	/*
+	 * Remember the partition we found for next time.  A list partition may
+	 * accept several values, so remember the bound that matched, too.
+	 */
+	if (part_index == partdesc->last_found_part_index)
+	{
+		partdesc->last_found_datum_index = bound_offset;
+		if (partdesc->last_found_count < PARTITION_CACHED_FIND_THRESHOLD)
+			partdesc->last_found_count++;
+	}
+	else
+	{
+		partdesc->last_found_count = 1;
+		partdesc->last_found_part_index = part_index;
+		partdesc->last_found_datum_index = bound_offset;
+	}
 
 	return part_index;
 }
@@ -1618,6 +1714,11 @@ adjust_partition_colnos_using_map(List *colnos, AttrMap *attrMap)
  *		matching subplans based on performing the initial pruning steps and
  *		then must be called again each time the value of a Param listed in
  *		PartitionPruneState's 'execparamids' changes.
+ *
+ * ExecGetUnprunedLeafRelids:
+ *		Performs the initial pruning steps of a plan's lockable
+ *		PartitionPruneInfos without starting up the executor, so that the
+ *		plan cache can avoid locking partitions that will be pruned anyway.
  *-------------------------------------------------------------------------
  */
 
@@ -1648,7 +1749,9 @@ ExecInitPartitionPruning(PlanState *planstate,
 	ExecAssignExprContext(estate, planstate);
 
 	/* Create the working data structure for pruning */
-	prunestate = CreatePartitionPruneState(planstate, pruneinfo);
+	prunestate = CreatePartitionPruneState(estate, planstate,
+										   planstate->ps_ExprContext,
+										   pruneinfo);
 
 	/*
 	 * Perform an initial partition prune pass, if required.
@@ -1688,7 +1791,10 @@ ExecInitPartitionPruning(PlanState *planstate,
  * CreatePartitionPruneState
  *		Build the data structure required for calling ExecFindMatchingSubPlans
  *
- * 'planstate' is the parent plan node's execution state.
+ * 'planstate' is the parent plan node's execution state.  It may be NULL
+ * if only initial pruning is to be done, in which case the expressions are
+ * evaluated in 'econtext' using its external Params.  Otherwise 'econtext'
+ * must be the parent plan node's ExprContext.
  *
  * 'pruneinfo' is a PartitionPruneInfo as generated by
  * make_partition_pruneinfo.  Here we build a PartitionPruneState containing a
@@ -1702,14 +1808,14 @@ ExecInitPartitionPruning(PlanState *planstate,
  * PartitionedRelPruneInfo.
  */
 static PartitionPruneState *
-CreatePartitionPruneState(PlanState *planstate, PartitionPruneInfo *pruneinfo)
+CreatePartitionPruneState(EState *estate, PlanState *planstate,
+						  ExprContext *econtext,
+						  PartitionPruneInfo *pruneinfo)
 {
-	EState	   *estate = planstate->state;
 	PartitionPruneState *prunestate;
 	int			n_part_hierarchies;
 	ListCell   *lc;
 	int			i;
-	ExprContext *econtext = planstate->ps_ExprContext;
 
 	/* For data reading, executor always omits detached partitions */
 	if (estate->es_partition_directory == NULL)
@@ -1888,8 +1994,10 @@ CreatePartitionPruneState(PlanState *planstate, PartitionPruneInfo *pruneinfo)
 				/* Record whether initial pruning is needed at any level */
 				prunestate->do_initial_prune = true;
 			}
-			pprune->exec_pruning_steps = pinfo->exec_pruning_steps;
-			if (pinfo->exec_pruning_steps)
+			/* Exec pruning needs a parent plan node to evaluate Params */
+			pprune->exec_pruning_steps =
+				planstate ? pinfo->exec_pruning_steps : NIL;
+			if (pprune->exec_pruning_steps)
 			{
 				InitPartitionPruneContext(&pprune->exec_context,
 										  pinfo->exec_pruning_steps,
@@ -2175,6 +2283,76 @@ ExecFindMatchingSubPlans(PartitionPruneState *prunestate,
 	return result;
 }
 
+/*
+ * ExecGetUnprunedLeafRelids
+ *		Determine which of a plan's prunable leaf partitions survive initial
+ *		partition pruning
+ *
+ * Returns the subset of plannedstmt->prunableRelids that the executor will
+ * scan when it is started with the given external Params.  The partitioned
+ * tables referenced by the plan must already be locked by the caller.
+ */
+Bitmapset *
+ExecGetUnprunedLeafRelids(PlannedStmt *plannedstmt, ParamListInfo params)
+{
+	Bitmapset  *result = NULL;
+	EState	   *estate;
+	ExprContext *econtext;
+	MemoryContext oldcontext;
+	ListCell   *lc;
+
+	estate = CreateExecutorState();
+	estate->es_param_list_info = params;
+
+	oldcontext = MemoryContextSwitchTo(estate->es_query_cxt);
+	ExecInitRangeTable(estate, plannedstmt->rtable);
+	econtext = CreateExprContext(estate);
+	MemoryContextSwitchTo(oldcontext);
+
+	foreach(lc, plannedstmt->partPruneInfos)
+	{
+		PartitionPruneInfo *pruneinfo = lfirst_node(PartitionPruneInfo, lc);
+		PartitionPruneState *prunestate;
+		Bitmapset  *validsubplans;
+		ListCell   *lc2;
+
+		oldcontext = MemoryContextSwitchTo(estate->es_query_cxt);
+		prunestate = CreatePartitionPruneState(estate, NULL, econtext,
+											   pruneinfo);
+		Assert(prunestate->do_initial_prune);
+		validsubplans = ExecFindMatchingSubPlans(prunestate, true);
+		MemoryContextSwitchTo(oldcontext);
+
+		/* Map the surviving subplans back to their leaf partitions */
+		foreach(lc2, pruneinfo->prune_infos)
+		{
+			List	   *prune_infos = lfirst(lc2);
+			ListCell   *lc3;
+
+			foreach(lc3, prune_infos)
+			{
+				PartitionedRelPruneInfo *pinfo = lfirst(lc3);
+				int			i;
+
+				for (i = 0; i < pinfo->nparts; i++)
+				{
+					if (pinfo->leafpart_rti_map[i] != 0 &&
+						bms_is_member(pinfo->subplan_map[i], validsubplans))
+						result = bms_add_member(result,
+												pinfo->leafpart_rti_map[i]);
+				}
+			}
+		}
+	}
+
+	ExecCloseRangeTableRelations(estate);
+	if (estate->es_partition_directory)
+		DestroyPartitionDirectory(estate->es_partition_directory);
+	FreeExecutorState(estate);
+
+	return result;
+}
+
 /*
  * find_matching_subplans_recurse
  *		Recursive worker function for ExecFindMatchingSubPlans
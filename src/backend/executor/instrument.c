@@ -24,6 +24,7 @@ static WalUsage save_pgWalUsage;
 
 static void BufferUsageAdd(BufferUsage *dst, const BufferUsage *add);
 static void WalUsageAdd(WalUsage *dst, WalUsage *add);
+static double InstrGetCycleTime(Instrumentation *instr);
 
 
 /* Allocate new instrumentation structure(s) */
@@ -39,6 +40,8 @@ InstrAlloc(int n, int instrument_options, bool async_mode)
 		bool		need_buffers = (instrument_options & INSTRUMENT_BUFFERS) != 0;
 		bool		need_wal = (instrument_options & INSTRUMENT_WAL) != 0;
 		bool		need_timer = (instrument_options & INSTRUMENT_TIMER) != 0;
+		bool		sample_timer = need_timer &&
+		(instrument_options & INSTRUMENT_TIMER_SAMPLED) != 0;
 		int			i;
 
 		for (i = 0; i < n; i++)
@@ -46,6 +49,7 @@ InstrAlloc(int n, int instrument_options, bool async_mode)
 			instr[i].need_bufusage = need_buffers;
 			instr[i].need_walusage = need_wal;
 			instr[i].need_timer = need_timer;
+			instr[i].sample_timer = sample_timer;
 			instr[i].async_mode = async_mode;
 		}
 	}
@@ -61,15 +65,30 @@ InstrInit(Instrumentation *instr, int instrument_options)
 	instr->need_bufusage = (instrument_options & INSTRUMENT_BUFFERS) != 0;
 	instr->need_walusage = (instrument_options & INSTRUMENT_WAL) != 0;
 	instr->need_timer = (instrument_options & INSTRUMENT_TIMER) != 0;
+	instr->sample_timer = instr->need_timer &&
+		(instrument_options & INSTRUMENT_TIMER_SAMPLED) != 0;
 }
 
 /* Entry to a plan node */
 void
 InstrStartNode(Instrumentation *instr)
 {
+	/*
+	 * In sampled mode, read the clock only on the first two calls of the
+	 * cycle and on every INSTR_TIMER_SAMPLE_PERIOD'th call after that, so
+	 * that there's always a timed call besides the first one to extrapolate
+	 * from.  Other calls leave starttime zero, which tells InstrStopNode not
+	 * to time them.
+	 */
 	if (instr->need_timer &&
-		!INSTR_TIME_SET_CURRENT_LAZY(instr->starttime))
-		elog(ERROR, "InstrStartNode called twice in a row");
+		(!instr->sample_timer ||
+		 instr->ncalls++ % INSTR_TIMER_SAMPLE_PERIOD == 0 ||
+		 instr->ncalls == 2))
+	{
+		if (!INSTR_TIME_SET_CURRENT_LAZY(instr->starttime))
+			elog(ERROR, "InstrStartNode called twice in a row");
+		instr->ntimed++;
+	}
 
 	/* save buffer usage totals at node entry, if needed */
 	if (instr->need_bufusage)
@@ -92,13 +111,18 @@ InstrStopNode(Instrumentation *instr, double nTuples)
 	/* let's update the time only if the timer was requested */
 	if (instr->need_timer)
 	{
-		if (INSTR_TIME_IS_ZERO(instr->starttime))
-			elog(ERROR, "InstrStopNode called without start");
+		if (!INSTR_TIME_IS_ZERO(instr->starttime))
+		{
+			INSTR_TIME_SET_CURRENT(endtime);
+			INSTR_TIME_ACCUM_DIFF(instr->counter, endtime, instr->starttime);
 
-		INSTR_TIME_SET_CURRENT(endtime);
-		INSTR_TIME_ACCUM_DIFF(instr->counter, endtime, instr->starttime);
+			INSTR_TIME_SET_ZERO(instr->starttime);
 
-		INSTR_TIME_SET_ZERO(instr->starttime);
+			if (instr->ntimed == 1)
+				instr->firstcall = INSTR_TIME_GET_DOUBLE(instr->counter);
+		}
+		else if (!instr->sample_timer)
+			elog(ERROR, "InstrStopNode called without start");
 	}
 
 	/* Add delta of buffer usage since entry to node's totals */
@@ -114,7 +138,7 @@ InstrStopNode(Instrumentation *instr, double nTuples)
 	if (!instr->running)
 	{
 		instr->running = true;
-		instr->firsttuple = INSTR_TIME_GET_DOUBLE(instr->counter);
+		instr->firsttuple = InstrGetCycleTime(instr);
 	}
 	else
 	{
@@ -123,7 +147,7 @@ InstrStopNode(Instrumentation *instr, double nTuples)
 		 * this might be the first tuple
 		 */
 		if (instr->async_mode && save_tuplecount < 1.0)
-			instr->firsttuple = INSTR_TIME_GET_DOUBLE(instr->counter);
+			instr->firsttuple = InstrGetCycleTime(instr);
 	}
 }
 
@@ -149,7 +173,7 @@ InstrEndLoop(Instrumentation *instr)
 		elog(ERROR, "InstrEndLoop called on running node");
 
 	/* Accumulate per-cycle statistics into totals */
-	totaltime = INSTR_TIME_GET_DOUBLE(instr->counter);
+	totaltime = InstrGetCycleTime(instr);
 
 	instr->startup += instr->firsttuple;
 	instr->total += totaltime;
@@ -160,10 +184,32 @@ InstrEndLoop(Instrumentation *instr)
 	instr->running = false;
 	INSTR_TIME_SET_ZERO(instr->starttime);
 	INSTR_TIME_SET_ZERO(instr->counter);
+	instr->ncalls = 0;
+	instr->ntimed = 0;
+	instr->firstcall = 0;
 	instr->firsttuple = 0;
 	instr->tuplecount = 0;
 }
 
+/*
+ * Runtime of the current cycle so far, in seconds.  In sampled mode, the
+ * first call is always timed and counted as is, since it often includes
+ * startup work that the other calls don't; the time of the other timed calls
+ * is scaled up to all the other calls of the cycle.
+ */
+static double
+InstrGetCycleTime(Instrumentation *instr)
+{
+	double		time = INSTR_TIME_GET_DOUBLE(instr->counter);
+
+	if (instr->sample_timer && instr->ntimed > 1 &&
+		instr->ncalls > instr->ntimed)
+		time = instr->firstcall + (time - instr->firstcall) *
+			(instr->ncalls - 1) / (instr->ntimed - 1);
+
+	return time;
+}
+
 /* aggregate instrumentation information */
 void
 InstrAggNode(Instrumentation *dst, Instrumentation *add)
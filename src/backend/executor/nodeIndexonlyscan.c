@@ -31,10 +31,12 @@
 #include "postgres.h"
 
 #include "access/genam.h"
+#include "access/heapam.h"
 #include "access/relscan.h"
 #include "access/tableam.h"
 #include "access/tupdesc.h"
 #include "access/visibilitymap.h"
+#include "access/xact.h"
 #include "executor/execdebug.h"
 #include "executor/nodeIndexonlyscan.h"
 #include "executor/nodeIndexscan.h"
@@ -157,14 +159,28 @@ IndexOnlyNext(IndexOnlyScanState *node)
 		 *
 		 * It's worth going through this complexity to avoid needing to lock
 		 * the VM buffer, which could cause significant contention.
+		 *
+		 * Failing that, we can also skip the heap fetch if we've already
+		 * found every tuple on the heap page to be visible to our snapshot.
+		 * That's typical of recently loaded append-only tables, where VACUUM
+		 * hasn't had a chance to set VM bits yet, but many consecutive index
+		 * entries point to the same heap page.
 		 */
 		if (!VM_ALL_VISIBLE(scandesc->heapRelation,
 							ItemPointerGetBlockNumber(tid),
-							&node->ioss_VMBuffer))
+							&node->ioss_VMBuffer) &&
+			!(ItemPointerGetBlockNumber(tid) == node->ioss_VisibleBlock &&
+			  ItemPointerGetOffsetNumber(tid) <= node->ioss_VisibleMaxOffset))
 		{
+			BlockNumber blkno = ItemPointerGetBlockNumber(tid);
+			bool		revisit;
+
 			/*
 			 * Rats, we have to visit the heap to check visibility.
 			 */
+			revisit = (blkno == node->ioss_LastHeapBlock);
+			node->ioss_LastHeapBlock = blkno;
+
 			InstrCountTuples2(node, 1);
 			if (!index_fetch_heap(scandesc, node->ioss_TableSlot))
 				continue;		/* no visible tuple, try next index entry */
@@ -180,6 +196,32 @@ IndexOnlyNext(IndexOnlyScanState *node)
 			if (scandesc->xs_heap_continue)
 				elog(ERROR, "non-MVCC snapshots are not supported in index-only scans");
 
+			/*
+			 * If this is the second consecutive index entry pointing to this
+			 * heap page, it seems likely more will follow, so check whether
+			 * the entire page is visible to us.  We check each page only
+			 * once, whatever the outcome, to bound the extra work on pages
+			 * that don't qualify.
+			 */
+			if (revisit && node->ioss_CheckHeapPages &&
+				blkno != node->ioss_CheckedBlock)
+			{
+				IndexFetchHeapData *hscan =
+				(IndexFetchHeapData *) scandesc->xs_heapfetch;
+				OffsetNumber maxoff;
+
+				Assert(BufferGetBlockNumber(hscan->xs_cbuf) == blkno);
+				node->ioss_CheckedBlock = blkno;
+				if (heap_page_visible_to_snapshot(scandesc->heapRelation,
+												  hscan->xs_cbuf,
+												  estate->es_snapshot,
+												  &maxoff))
+				{
+					node->ioss_VisibleBlock = blkno;
+					node->ioss_VisibleMaxOffset = maxoff;
+				}
+			}
+
 			/*
 			 * Note: at this point we are holding a pin on the heap page, as
 			 * recorded in scandesc->xs_cbuf.  We could release that pin now,
@@ -575,6 +617,22 @@ ExecInitIndexOnlyScan(IndexOnlyScan *node, EState *estate, int eflags)
 	indexstate->ioss_RuntimeKeys = NULL;
 	indexstate->ioss_NumRuntimeKeys = 0;
 
+	/*
+	 * Decide whether heap pages whose visibility map bit isn't set may be
+	 * checked for visibility as a whole; see IndexOnlyNext.  That's only
+	 * possible for heap relations.  It's also not done at serializable
+	 * isolation level, since skipping the heap fetch would skip the
+	 * serialization conflict checks made when reading the tuple.
+	 */
+	indexstate->ioss_CheckHeapPages =
+		currentRelation->rd_tableam == GetHeapamTableAmRoutine() &&
+		IsMVCCSnapshot(estate->es_snapshot) &&
+		!IsolationIsSerializable();
+	indexstate->ioss_LastHeapBlock = InvalidBlockNumber;
+	indexstate->ioss_CheckedBlock = InvalidBlockNumber;
+	indexstate->ioss_VisibleBlock = InvalidBlockNumber;
+	indexstate->ioss_VisibleMaxOffset = InvalidOffsetNumber;
+
 	/*
 	 * build the index scan keys from the index qualification
 	 */
@@ -22,10 +22,25 @@
 #include "postgres.h"
 
 #include "executor/execdebug.h"
+#include "executor/executor.h"
 #include "executor/nodeNestloop.h"
 #include "miscadmin.h"
 #include "utils/memutils.h"
 
+/*
+ * If the inner plan does not depend on the outer tuple, and the outer plan
+ * turns out to return more than this many times the number of rows the
+ * planner estimated, materialize the inner relation on its next scan instead
+ * of rescanning it for every outer tuple.  The planner will usually have
+ * decided against a Material node because it expected few rescans.
+ */
+#define NESTLOOP_ADAPT_FACTOR	10.0
+
+/* GUC parameter */
+bool		enable_adaptive_material = true;
+
+static TupleTableSlot *ExecNestLoopFetchInner(NestLoopState *node);
+
 
 /* ----------------------------------------------------------------
  *		ExecNestLoop(node)
@@ -121,6 +136,7 @@ ExecNestLoop(PlanState *pstate)
 			econtext->ecxt_outertuple = outerTupleSlot;
 			node->nl_NeedNewOuter = false;
 			node->nl_MatchedOuter = false;
+			node->nl_OuterTuples += 1;
 
 			/*
 			 * fetch the values of any outer Vars that must be passed to the
@@ -146,10 +162,33 @@ ExecNestLoop(PlanState *pstate)
 			}
 
 			/*
-			 * now rescan the inner plan
+			 * now rescan the inner plan, or the materialized copy of it.  If
+			 * the scan that was to fill the copy stopped early, complete it
+			 * first.
 			 */
-			ENL1_printf("rescanning inner plan");
-			ExecReScan(innerPlan);
+			if (node->nl_InnerTuples != NULL)
+			{
+				ENL1_printf("rescanning materialized inner plan");
+				while (!node->nl_InnerComplete)
+					(void) ExecNestLoopFetchInner(node);
+				tuplestore_rescan(node->nl_InnerTuples);
+			}
+			else
+			{
+				if (node->nl_AdaptiveMaterial &&
+					node->nl_OuterTuples > NESTLOOP_ADAPT_FACTOR *
+					Max(outerPlan->plan->plan_rows, 1.0))
+				{
+					ENL1_printf("materializing inner plan");
+					node->nl_InnerTuples = tuplestore_begin_heap(false, false,
+																 work_mem);
+					node->nl_InnerComplete = false;
+					node->nl_InnerMaterialized = true;
+				}
+
+				ENL1_printf("rescanning inner plan");
+				ExecReScan(innerPlan);
+			}
 		}
 
 		/*
@@ -157,7 +196,10 @@ ExecNestLoop(PlanState *pstate)
 		 */
 		ENL1_printf("getting new inner tuple");
 
-		innerTupleSlot = ExecProcNode(innerPlan);
+		if (node->nl_InnerTuples != NULL)
+			innerTupleSlot = ExecNestLoopFetchInner(node);
+		else
+			innerTupleSlot = ExecProcNode(innerPlan);
 		econtext->ecxt_innertuple = innerTupleSlot;
 
 		if (TupIsNull(innerTupleSlot))
@@ -255,6 +297,36 @@ ExecNestLoop(PlanState *pstate)
 	}
 }
 
+/*
+ * Fetch the next inner tuple once the inner plan is being materialized.
+ *
+ * While the inner relation is being scanned for the first time, its tuples
+ * are returned and also saved; after that they are read back.
+ */
+static TupleTableSlot *
+ExecNestLoopFetchInner(NestLoopState *node)
+{
+	TupleTableSlot *slot;
+
+	if (node->nl_InnerComplete)
+	{
+		if (!tuplestore_gettupleslot(node->nl_InnerTuples, true, false,
+									 node->nl_InnerStoreSlot))
+			return ExecClearTuple(node->nl_InnerTupleSlot);
+		if (node->nl_InnerTupleSlot != node->nl_InnerStoreSlot)
+			ExecCopySlot(node->nl_InnerTupleSlot, node->nl_InnerStoreSlot);
+		return node->nl_InnerTupleSlot;
+	}
+
+	slot = ExecProcNode(innerPlanState(node));
+	if (TupIsNull(slot))
+		node->nl_InnerComplete = true;
+	else
+		tuplestore_puttupleslot(node->nl_InnerTuples, slot);
+
+	return slot;
+}
+
 /* ----------------------------------------------------------------
  *		ExecInitNestLoop
  * ----------------------------------------------------------------
@@ -301,6 +373,36 @@ ExecInitNestLoop(NestLoop *node, EState *estate, int eflags)
 		eflags &= ~EXEC_FLAG_REWIND;
 	innerPlanState(nlstate) = ExecInitNode(innerPlan(node), estate, eflags);
 
+	/*
+	 * Unless the inner plan depends on the outer tuple, or already
+	 * materializes its output, we may decide to materialize it at runtime.
+	 * The tuplestore returns minimal tuples.  If the inner plan always
+	 * returns a different kind of slot, the tuples read back are copied into
+	 * a slot of that kind, so that the join's expressions can keep relying on
+	 * the inner slot type.  That costs a copy per tuple, but only once we
+	 * have materialized.
+	 */
+	nlstate->nl_AdaptiveMaterial = enable_adaptive_material &&
+		node->nestParams == NIL &&
+		!ExecMaterializesOutput(nodeTag(innerPlan(node)));
+	if (nlstate->nl_AdaptiveMaterial)
+	{
+		TupleDesc	innerDesc = ExecGetResultType(innerPlanState(nlstate));
+		const TupleTableSlotOps *innerOps;
+		bool		innerOpsFixed;
+
+		nlstate->nl_InnerStoreSlot =
+			ExecInitExtraTupleSlot(estate, innerDesc, &TTSOpsMinimalTuple);
+
+		innerOps = ExecGetResultSlotOps(innerPlanState(nlstate),
+										&innerOpsFixed);
+		if (innerOpsFixed && innerOps != &TTSOpsMinimalTuple)
+			nlstate->nl_InnerTupleSlot =
+				ExecInitExtraTupleSlot(estate, innerDesc, innerOps);
+		else
+			nlstate->nl_InnerTupleSlot = nlstate->nl_InnerStoreSlot;
+	}
+
 	/*
 	 * Initialize result slot, type and projection.
 	 */
@@ -345,6 +447,10 @@ ExecInitNestLoop(NestLoop *node, EState *estate, int eflags)
 	 */
 	nlstate->nl_NeedNewOuter = true;
 	nlstate->nl_MatchedOuter = false;
+	nlstate->nl_OuterTuples = 0;
+	nlstate->nl_InnerTuples = NULL;
+	nlstate->nl_InnerComplete = false;
+	nlstate->nl_InnerMaterialized = false;
 
 	NL1_printf("ExecInitNestLoop: %s\n",
 			   "node initialized");
@@ -374,6 +480,13 @@ ExecEndNestLoop(NestLoopState *node)
 	 */
 	ExecClearTuple(node->js.ps.ps_ResultTupleSlot);
 
+	/*
+	 * Release tuplestore resources
+	 */
+	if (node->nl_InnerTuples != NULL)
+		tuplestore_end(node->nl_InnerTuples);
+	node->nl_InnerTuples = NULL;
+
 	/*
 	 * close down subplans
 	 */
@@ -404,8 +517,18 @@ ExecReScanNestLoop(NestLoopState *node)
 	 * innerPlan is re-scanned for each new outer tuple and MUST NOT be
 	 * re-scanned from here or you'll get troubles from inner index scans when
 	 * outer Vars are used as run-time keys...
+	 *
+	 * A materialized copy of it remains valid, unless it's incomplete or the
+	 * inner plan's parameters have changed.
 	 */
+	if (node->nl_InnerTuples != NULL &&
+		(!node->nl_InnerComplete || innerPlanState(node)->chgParam != NULL))
+	{
+		tuplestore_end(node->nl_InnerTuples);
+		node->nl_InnerTuples = NULL;
+	}
 
 	node->nl_NeedNewOuter = true;
 	node->nl_MatchedOuter = false;
+	node->nl_OuterTuples = 0;
 }
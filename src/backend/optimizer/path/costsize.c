@@ -152,6 +152,10 @@ bool		enable_parallel_hash = true;
 bool		enable_partition_pruning = true;
 bool		enable_async_append = true;
 
+/* Hooks for plugins to adjust row count estimates */
+baserel_rows_estimate_hook_type baserel_rows_estimate_hook = NULL;
+joinrel_rows_estimate_hook_type joinrel_rows_estimate_hook = NULL;
+
 typedef struct
 {
 	PlannerInfo *root;
@@ -5273,6 +5277,9 @@ set_baserel_size_estimates(PlannerInfo *root, RelOptInfo *rel)
 							   JOIN_INNER,
 							   NULL);
 
+	if (baserel_rows_estimate_hook)
+		nrows = (*baserel_rows_estimate_hook) (root, rel, NIL, nrows);
+
 	rel->rows = clamp_row_est(nrows);
 
 	cost_qual_eval(&rel->baserestrictcost, rel->baserestrictinfo, root);
@@ -5308,6 +5315,9 @@ get_parameterized_baserel_size(PlannerInfo *root, RelOptInfo *rel,
 							   rel->relid,	/* do not use 0! */
 							   JOIN_INNER,
 							   NULL);
+	if (baserel_rows_estimate_hook)
+		nrows = (*baserel_rows_estimate_hook) (root, rel, param_clauses,
+											   nrows);
 	nrows = clamp_row_est(nrows);
 	/* For safety, make sure result is not more than the base estimate */
 	if (nrows > rel->rows)
@@ -5544,6 +5554,13 @@ calc_joinrel_size_estimate(PlannerInfo *root,
 			break;
 	}
 
+	if (joinrel_rows_estimate_hook)
+		nrows = (*joinrel_rows_estimate_hook) (root, joinrel,
+											   outer_rel, inner_rel,
+											   outer_rows, inner_rows,
+											   sjinfo, restrictlist_in,
+											   nrows);
+
 	return clamp_row_est(nrows);
 }
 
@@ -308,6 +308,8 @@ standard_planner(Query *parse, const char *query_string, int cursorOptions,
 	glob->finalrowmarks = NIL;
 	glob->resultRelations = NIL;
 	glob->appendRelations = NIL;
+	glob->partPruneInfos = NIL;
+	glob->prunableRelids = NULL;
 	glob->relationOids = NIL;
 	glob->invalItems = NIL;
 	glob->paramExecTypes = NIL;
@@ -524,6 +526,19 @@ standard_planner(Query *parse, const char *query_string, int cursorOptions,
 	result->subplans = glob->subplans;
 	result->rewindPlanIDs = glob->rewindPlanIDs;
 	result->rowMarks = glob->finalrowmarks;
+
+	/*
+	 * Skipping the locks of pruned partitions is only safe for plain SELECTs.
+	 * Row marks and data-modifying CTEs make the executor open relations
+	 * regardless of whether their scans survive initial pruning.
+	 */
+	if (parse->commandType == CMD_SELECT &&
+		!parse->hasModifyingCTE &&
+		glob->finalrowmarks == NIL)
+	{
+		result->partPruneInfos = glob->partPruneInfos;
+		result->prunableRelids = glob->prunableRelids;
+	}
 	result->relationOids = glob->relationOids;
 	result->invalItems = glob->invalItems;
 	result->paramExecTypes = glob->paramExecTypes;
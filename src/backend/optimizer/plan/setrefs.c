@@ -136,6 +136,10 @@ static Plan *set_mergeappend_references(PlannerInfo *root,
 										MergeAppend *mplan,
 										int rtoffset);
 static void set_hash_references(PlannerInfo *root, Plan *plan, int rtoffset);
+static void register_partpruneinfo(PlannerInfo *root,
+								   PartitionPruneInfo *pruneinfo,
+								   int rtoffset);
+static bool initial_pruning_is_immutable(PartitionPruneInfo *pruneinfo);
 static Relids offset_relid_set(Relids relids, int rtoffset);
 static Node *fix_scan_expr(PlannerInfo *root, Node *node,
 						   int rtoffset, double num_exec);
@@ -1641,20 +1645,7 @@ set_append_references(PlannerInfo *root,
 	aplan->apprelids = offset_relid_set(aplan->apprelids, rtoffset);
 
 	if (aplan->part_prune_info)
-	{
-		foreach(l, aplan->part_prune_info->prune_infos)
-		{
-			List	   *prune_infos = lfirst(l);
-			ListCell   *l2;
-
-			foreach(l2, prune_infos)
-			{
-				PartitionedRelPruneInfo *pinfo = lfirst(l2);
-
-				pinfo->rtindex += rtoffset;
-			}
-		}
-	}
+		register_partpruneinfo(root, aplan->part_prune_info, rtoffset);
 
 	/* We don't need to recurse to lefttree or righttree ... */
 	Assert(aplan->plan.lefttree == NULL);
@@ -1713,26 +1704,105 @@ set_mergeappend_references(PlannerInfo *root,
 	mplan->apprelids = offset_relid_set(mplan->apprelids, rtoffset);
 
 	if (mplan->part_prune_info)
+		register_partpruneinfo(root, mplan->part_prune_info, rtoffset);
+
+	/* We don't need to recurse to lefttree or righttree ... */
+	Assert(mplan->plan.lefttree == NULL);
+	Assert(mplan->plan.righttree == NULL);
+
+	return (Plan *) mplan;
+}
+
+/*
+ * register_partpruneinfo
+ *		Adjust the RT indexes in a PartitionPruneInfo, and remember it in the
+ *		global list if its initial pruning steps can be performed before the
+ *		partitions it covers are locked
+ *
+ * AcquireExecutorLocks() uses the list to avoid locking leaf partitions of
+ * a generic plan that initial pruning would remove anyway.  That's only
+ * safe if pruning gives the same answer there and in the executor, so we
+ * only accept steps that compare against immutable expressions, typically
+ * external Params.  Leaf partition RT indexes are referenced only by the
+ * subplans of the Append or MergeAppend that owns the PartitionPruneInfo,
+ * so the executor will not touch the ones that are pruned.
+ */
+static void
+register_partpruneinfo(PlannerInfo *root, PartitionPruneInfo *pruneinfo,
+					   int rtoffset)
+{
+	PlannerGlobal *glob = root->glob;
+	Bitmapset  *leafrelids = NULL;
+	ListCell   *l;
+
+	foreach(l, pruneinfo->prune_infos)
 	{
-		foreach(l, mplan->part_prune_info->prune_infos)
+		List	   *prune_infos = lfirst(l);
+		ListCell   *l2;
+
+		foreach(l2, prune_infos)
 		{
-			List	   *prune_infos = lfirst(l);
-			ListCell   *l2;
+			PartitionedRelPruneInfo *pinfo = lfirst(l2);
+			int			i;
 
-			foreach(l2, prune_infos)
-			{
-				PartitionedRelPruneInfo *pinfo = lfirst(l2);
+			pinfo->rtindex += rtoffset;
 
-				pinfo->rtindex += rtoffset;
+			for (i = 0; i < pinfo->nparts; i++)
+			{
+				if (pinfo->leafpart_rti_map[i] == 0)
+					continue;
+				pinfo->leafpart_rti_map[i] += rtoffset;
+				leafrelids = bms_add_member(leafrelids,
+											pinfo->leafpart_rti_map[i]);
 			}
 		}
 	}
 
-	/* We don't need to recurse to lefttree or righttree ... */
-	Assert(mplan->plan.lefttree == NULL);
-	Assert(mplan->plan.righttree == NULL);
+	if (initial_pruning_is_immutable(pruneinfo))
+	{
+		glob->partPruneInfos = lappend(glob->partPruneInfos, pruneinfo);
+		glob->prunableRelids = bms_add_members(glob->prunableRelids,
+											   leafrelids);
+	}
+}
 
-	return (Plan *) mplan;
+/*
+ * initial_pruning_is_immutable
+ *		Does the PartitionPruneInfo have initial pruning steps, all of which
+ *		compare only against immutable expressions?
+ */
+static bool
+initial_pruning_is_immutable(PartitionPruneInfo *pruneinfo)
+{
+	bool		have_steps = false;
+	ListCell   *l;
+
+	foreach(l, pruneinfo->prune_infos)
+	{
+		List	   *prune_infos = lfirst(l);
+		ListCell   *l2;
+
+		foreach(l2, prune_infos)
+		{
+			PartitionedRelPruneInfo *pinfo = lfirst(l2);
+			ListCell   *l3;
+
+			foreach(l3, pinfo->initial_pruning_steps)
+			{
+				PartitionPruneStepOp *step = lfirst(l3);
+
+				have_steps = true;
+
+				/* combine steps have no expressions */
+				if (!IsA(step, PartitionPruneStepOp))
+					continue;
+				if (contain_mutable_functions((Node *) step->exprs))
+					return false;
+			}
+		}
+	}
+
+	return have_steps;
 }
 
 /*
@@ -183,6 +183,14 @@ typedef struct av_relation
 								 * reloptions, or NULL if none */
 } av_relation;
 
+/* struct to keep track of tables that need work, for prioritizing them */
+typedef struct av_candidate
+{
+	Oid			ac_relid;
+	bool		ac_wraparound;	/* at risk of wraparound? */
+	double		ac_score;		/* how urgently it needs work */
+} av_candidate;
+
 /* struct to keep track of tables to vacuum and/or analyze, after rechecking */
 typedef struct autovac_table
 {
@@ -272,9 +280,11 @@ typedef struct AutoVacuumWorkItem
  * av_startingWorker pointer to WorkerInfo currently being started (cleared by
  *					the worker itself as soon as it's up and running)
  * av_workItems		work item array
+ * av_nPrunePageItems number of AVW_HeapPrunePage items in av_workItems
  *
  * This struct is protected by AutovacuumLock, except for av_signal and parts
- * of the worker list (see above).
+ * of the worker list (see above).  av_nPrunePageItems is only changed while
+ * holding AutovacuumLock, but may be read without it.
  *-------------
  */
 typedef struct
@@ -285,6 +295,7 @@ typedef struct
 	dlist_head	av_runningWorkers;
 	WorkerInfo	av_startingWorker;
 	AutoVacuumWorkItem av_workItems[NUM_WORKITEMS];
+	pg_atomic_uint32 av_nPrunePageItems;
 } AutoVacuumShmemStruct;
 
 static AutoVacuumShmemStruct *AutoVacuumShmem;
@@ -334,7 +345,11 @@ static void relation_needs_vacanalyze(Oid relid, AutoVacOpts *relopts,
 									  Form_pg_class classForm,
 									  PgStat_StatTabEntry *tabentry,
 									  int effective_multixact_freeze_max_age,
-									  bool *dovacuum, bool *doanalyze, bool *wraparound);
+									  bool *dovacuum, bool *doanalyze, bool *wraparound,
+									  double *score);
+static List *add_candidate_table(List *candidates, Oid relid,
+								 bool wraparound, double score);
+static int	candidate_priority_cmp(const ListCell *a, const ListCell *b);
 
 static void autovacuum_do_vac_analyze(autovac_table *tab,
 									  BufferAccessStrategy bstrategy);
@@ -1957,6 +1972,7 @@ do_autovacuum(void)
 	TableScanDesc relScan;
 	Form_pg_database dbForm;
 	List	   *table_oids = NIL;
+	List	   *candidates = NIL;
 	List	   *orphan_oids = NIL;
 	HASHCTL		ctl;
 	HTAB	   *table_toast_map;
@@ -2062,6 +2078,7 @@ do_autovacuum(void)
 		bool		dovacuum;
 		bool		doanalyze;
 		bool		wraparound;
+		double		score;
 
 		if (classForm->relkind != RELKIND_RELATION &&
 			classForm->relkind != RELKIND_MATVIEW)
@@ -2102,11 +2119,12 @@ do_autovacuum(void)
 		/* Check if it needs vacuum or analyze */
 		relation_needs_vacanalyze(relid, relopts, classForm, tabentry,
 								  effective_multixact_freeze_max_age,
-								  &dovacuum, &doanalyze, &wraparound);
+								  &dovacuum, &doanalyze, &wraparound, &score);
 
-		/* Relations that need work are added to table_oids */
+		/* Relations that need work are added to the candidates list */
 		if (dovacuum || doanalyze)
-			table_oids = lappend_oid(table_oids, relid);
+			candidates = add_candidate_table(candidates, relid,
+											 wraparound, score);
 
 		/*
 		 * Remember TOAST associations for the second pass.  Note: we must do
@@ -2155,6 +2173,7 @@ do_autovacuum(void)
 		bool		dovacuum;
 		bool		doanalyze;
 		bool		wraparound;
+		double		score;
 
 		/*
 		 * We cannot safely process other backends' temp tables, so skip 'em.
@@ -2185,16 +2204,33 @@ do_autovacuum(void)
 
 		relation_needs_vacanalyze(relid, relopts, classForm, tabentry,
 								  effective_multixact_freeze_max_age,
-								  &dovacuum, &doanalyze, &wraparound);
+								  &dovacuum, &doanalyze, &wraparound, &score);
 
 		/* ignore analyze for toast tables */
 		if (dovacuum)
-			table_oids = lappend_oid(table_oids, relid);
+			candidates = add_candidate_table(candidates, relid,
+											 wraparound, score);
 	}
 
 	table_endscan(relScan);
 	table_close(classRel, AccessShareLock);
 
+	/*
+	 * Process the tables in order of urgency rather than in pg_class order,
+	 * so that a table at risk of wraparound, or one that is far past its
+	 * thresholds, doesn't have to wait behind many that barely crossed them.
+	 * Other workers that start on this database later will compute the same
+	 * ordering, and skip over whatever tables are already being processed.
+	 */
+	list_sort(candidates, candidate_priority_cmp);
+	foreach(cell, candidates)
+	{
+		av_candidate *cand = (av_candidate *) lfirst(cell);
+
+		table_oids = lappend_oid(table_oids, cand->ac_relid);
+	}
+	list_free_deep(candidates);
+
 	/*
 	 * Recheck orphan temporary tables, and if they still seem orphaned, drop
 	 * them.  We'll eat a transaction per dropped table, which might seem
@@ -2569,6 +2605,8 @@ deleted:
 		LWLockAcquire(AutovacuumLock, LW_EXCLUSIVE);
 
 		/* and mark it done */
+		if (workitem->avw_type == AVW_HeapPrunePage)
+			pg_atomic_sub_fetch_u32(&AutoVacuumShmem->av_nPrunePageItems, 1);
 		workitem->avw_active = false;
 		workitem->avw_used = false;
 	}
@@ -2658,6 +2696,14 @@ perform_work_item(AutoVacuumWorkItem *workitem)
 									ObjectIdGetDatum(workitem->avw_relation),
 									Int64GetDatum((int64) workitem->avw_blockNumber));
 				break;
+			case AVW_HeapPrunePage:
+				heap_page_prune_deferred(workitem->avw_relation,
+										 workitem->avw_blockNumber);
+				break;
+			case AVW_GinCleanPendingList:
+				DirectFunctionCall1(gin_clean_pending_list,
+									ObjectIdGetDatum(workitem->avw_relation));
+				break;
 			default:
 				elog(WARNING, "unrecognized work item found: type %d",
 					 workitem->avw_type);
@@ -2913,7 +2959,7 @@ recheck_relation_needs_vacanalyze(Oid relid,
 
 	relation_needs_vacanalyze(relid, avopts, classForm, tabentry,
 							  effective_multixact_freeze_max_age,
-							  dovacuum, doanalyze, wraparound);
+							  dovacuum, doanalyze, wraparound, NULL);
 
 	/* ignore ANALYZE for toast tables */
 	if (classForm->relkind == RELKIND_TOASTVALUE)
@@ -2927,6 +2973,13 @@ recheck_relation_needs_vacanalyze(Oid relid,
  * "dovacuum" and "doanalyze", respectively.  Also return whether the vacuum is
  * being forced because of Xid or multixact wraparound.
  *
+ * If score isn't NULL, it is set to a measure of how urgently the relation
+ * needs work, for do_autovacuum to sort tables by.  For tables at risk of
+ * wraparound it is the age of relfrozenxid (or relminmxid) as a multiple of
+ * the applicable freeze_max_age; otherwise it is the largest ratio between a
+ * tuple count and its threshold, among the reasons we decided to act on.
+ * Either way, a table that needs work has a score of at least 1.
+ *
  * relopts is a pointer to the AutoVacOpts options (either for itself in the
  * case of a plain table, or for either itself or its parent table in the case
  * of a TOAST table), NULL if none; tabentry is the pgstats entry, which can be
@@ -2966,7 +3019,8 @@ relation_needs_vacanalyze(Oid relid,
  /* output params below */
 						  bool *dovacuum,
 						  bool *doanalyze,
-						  bool *wraparound)
+						  bool *wraparound,
+						  double *score)
 {
 	bool		force_vacuum;
 	bool		av_enabled;
@@ -3058,6 +3112,22 @@ relation_needs_vacanalyze(Oid relid,
 	}
 	*wraparound = force_vacuum;
 
+	if (score)
+	{
+		*score = 0;
+		if (force_vacuum)
+		{
+			if (TransactionIdIsNormal(classForm->relfrozenxid))
+				*score = Max(*score,
+							 (double) (int32) (recentXid - classForm->relfrozenxid) /
+							 Max(freeze_max_age, 1));
+			if (MultiXactIdIsValid(classForm->relminmxid))
+				*score = Max(*score,
+							 (double) (int32) (recentMulti - classForm->relminmxid) /
+							 Max(multixact_freeze_max_age, 1));
+		}
+	}
+
 	/* User disabled it in pg_class.reloptions?  (But ignore if at risk) */
 	if (!av_enabled && !force_vacuum)
 	{
@@ -3106,6 +3176,16 @@ relation_needs_vacanalyze(Oid relid,
 		*dovacuum = force_vacuum || (vactuples > vacthresh) ||
 			(vac_ins_base_thresh >= 0 && instuples > vacinsthresh);
 		*doanalyze = (anltuples > anlthresh);
+
+		if (score && !force_vacuum)
+		{
+			if (vactuples > vacthresh)
+				*score = Max(*score, vactuples / Max(vacthresh, 1));
+			if (vac_ins_base_thresh >= 0 && instuples > vacinsthresh)
+				*score = Max(*score, instuples / Max(vacinsthresh, 1));
+			if (*doanalyze)
+				*score = Max(*score, anltuples / Max(anlthresh, 1));
+		}
 	}
 	else
 	{
@@ -3123,6 +3203,45 @@ relation_needs_vacanalyze(Oid relid,
 		*doanalyze = false;
 }
 
+/*
+ * add_candidate_table
+ *		Append a table that needs work to do_autovacuum's list of candidates
+ */
+static List *
+add_candidate_table(List *candidates, Oid relid, bool wraparound, double score)
+{
+	av_candidate *cand = palloc(sizeof(av_candidate));
+
+	cand->ac_relid = relid;
+	cand->ac_wraparound = wraparound;
+	cand->ac_score = score;
+
+	return lappend(candidates, cand);
+}
+
+/*
+ * candidate_priority_cmp
+ *		list_sort comparator putting the most urgent candidate tables first
+ *
+ * Tables at risk of wraparound always go first.  Within each group, tables
+ * with a higher score come first; ties are broken by OID so that concurrent
+ * workers agree on the order.
+ */
+static int
+candidate_priority_cmp(const ListCell *a, const ListCell *b)
+{
+	av_candidate *ca = (av_candidate *) lfirst(a);
+	av_candidate *cb = (av_candidate *) lfirst(b);
+
+	if (ca->ac_wraparound != cb->ac_wraparound)
+		return ca->ac_wraparound ? -1 : 1;
+	if (ca->ac_score != cb->ac_score)
+		return ca->ac_score > cb->ac_score ? -1 : 1;
+	if (ca->ac_relid != cb->ac_relid)
+		return ca->ac_relid < cb->ac_relid ? -1 : 1;
+	return 0;
+}
+
 /*
  * autovacuum_do_vac_analyze
  *		Vacuum and/or analyze the specified table
@@ -3205,6 +3324,14 @@ autovac_report_workitem(AutoVacuumWorkItem *workitem,
 			snprintf(activity, MAX_AUTOVAC_ACTIV_LEN,
 					 "autovacuum: BRIN summarize");
 			break;
+		case AVW_HeapPrunePage:
+			snprintf(activity, MAX_AUTOVAC_ACTIV_LEN,
+					 "autovacuum: prune page");
+			break;
+		case AVW_GinCleanPendingList:
+			snprintf(activity, MAX_AUTOVAC_ACTIV_LEN,
+					 "autovacuum: GIN pending list cleanup");
+			break;
 	}
 
 	/*
@@ -3239,6 +3366,38 @@ AutoVacuumingActive(void)
 	return true;
 }
 
+/*
+ * Check whether a work item of the given type and target is already queued
+ * for our database.  If nsametype isn't NULL, also count the other queued
+ * items of that type into *nsametype.
+ *
+ * The caller must hold AutovacuumLock.
+ */
+static bool
+autovac_workitem_queued(AutoVacuumWorkItemType type, Oid relationId,
+						BlockNumber blkno, int *nsametype)
+{
+	int			i;
+
+	for (i = 0; i < NUM_WORKITEMS; i++)
+	{
+		AutoVacuumWorkItem *workitem = &AutoVacuumShmem->av_workItems[i];
+
+		if (!workitem->avw_used || workitem->avw_type != type)
+			continue;
+
+		if (workitem->avw_database == MyDatabaseId &&
+			workitem->avw_relation == relationId &&
+			workitem->avw_blockNumber == blkno)
+			return true;
+
+		if (nsametype)
+			(*nsametype)++;
+	}
+
+	return false;
+}
+
 /*
  * Request one work item to the next autovacuum run processing our database.
  * Return false if the request can't be recorded.
@@ -3250,8 +3409,61 @@ AutoVacuumRequestWork(AutoVacuumWorkItemType type, Oid relationId,
 	int			i;
 	bool		result = false;
 
+	/*
+	 * Page pruning requests are made every time a backend fails to get a
+	 * cleanup lock on a prunable page, so check whether there's room for
+	 * another one before taking AutovacuumLock.  This is only a hint, but
+	 * it's rechecked below.
+	 */
+	if (type == AVW_HeapPrunePage &&
+		pg_atomic_read_u32(&AutoVacuumShmem->av_nPrunePageItems) >=
+		NUM_WORKITEMS / 2)
+		return false;
+
+	/*
+	 * Every insert into a GIN index whose pending list has grown too long
+	 * requests its cleanup, until autovacuum gets to it.  Look for the
+	 * request queued by the first of them under a shared lock, so that
+	 * concurrent inserters don't queue up behind each other.
+	 */
+	if (type == AVW_GinCleanPendingList)
+	{
+		bool		queued;
+
+		LWLockAcquire(AutovacuumLock, LW_SHARED);
+		queued = autovac_workitem_queued(type, relationId, blkno, NULL);
+		LWLockRelease(AutovacuumLock);
+
+		if (queued)
+			return true;
+	}
+
 	LWLockAcquire(AutovacuumLock, LW_EXCLUSIVE);
 
+	/*
+	 * Page pruning and GIN pending list cleanup requests may be made
+	 * repeatedly for the same target; ignore requests that are already
+	 * queued.  Page pruning requests are merely opportunistic, and can be
+	 * numerous.  Don't let them crowd out other kinds of work items: accept
+	 * them only while they occupy less than half the array.
+	 */
+	if (type == AVW_HeapPrunePage || type == AVW_GinCleanPendingList)
+	{
+		int			nsametype = 0;
+
+		if (autovac_workitem_queued(type, relationId, blkno, &nsametype))
+		{
+			LWLockRelease(AutovacuumLock);
+			return true;
+		}
+
+		if (type == AVW_HeapPrunePage && nsametype >= NUM_WORKITEMS / 2)
+		{
+			LWLockRelease(AutovacuumLock);
+			return false;
+		}
+	}
+
 	/*
 	 * Locate an unused work item and fill it with the given data.
 	 */
@@ -3268,6 +3480,8 @@ AutoVacuumRequestWork(AutoVacuumWorkItemType type, Oid relationId,
 		workitem->avw_database = MyDatabaseId;
 		workitem->avw_relation = relationId;
 		workitem->avw_blockNumber = blkno;
+		if (type == AVW_HeapPrunePage)
+			pg_atomic_add_fetch_u32(&AutoVacuumShmem->av_nPrunePageItems, 1);
 		result = true;
 
 		/* done */
@@ -3358,6 +3572,7 @@ AutoVacuumShmemInit(void)
 		AutoVacuumShmem->av_startingWorker = NULL;
 		memset(AutoVacuumShmem->av_workItems, 0,
 			   sizeof(AutoVacuumWorkItem) * NUM_WORKITEMS);
+		pg_atomic_init_u32(&AutoVacuumShmem->av_nPrunePageItems, 0);
 
 		worker = (WorkerInfo) ((char *) AutoVacuumShmem +
 							   MAXALIGN(sizeof(AutoVacuumShmemStruct)));
@@ -33,6 +33,7 @@
 #include "replication/backup_manifest.h"
 #include "replication/walsender.h"
 #include "replication/walsender_private.h"
+#include "storage/bufmgr.h"
 #include "storage/bufpage.h"
 #include "storage/checksum.h"
 #include "storage/dsm_impl.h"
@@ -93,6 +94,8 @@ static void perform_base_backup(basebackup_options *opt, bbsink *sink);
 static void parse_basebackup_options(List *options, basebackup_options *opt);
 static int	compareWalFileNames(const ListCell *a, const ListCell *b);
 static bool is_checksummed_file(const char *fullpath, const char *filename);
+static void basebackup_prefetch_file(int fd, off_t *prefetched, off_t offset,
+									 off_t filesize);
 static int	basebackup_read_file(int fd, char *buf, size_t nbytes, off_t offset,
 								 const char *filename, bool partial_read_ok);
 
@@ -1497,6 +1500,7 @@ sendFile(bbsink *sink, const char *readfilename, const char *tarfilename,
 	int			segmentno = 0;
 	char	   *segmentpath;
 	bool		verify_checksum = false;
+	off_t		prefetched = 0;
 	pg_checksum_context checksum_ctx;
 
 	if (pg_checksum_init(&checksum_ctx, manifest->checksum_type) < 0)
@@ -1556,6 +1560,9 @@ sendFile(bbsink *sink, const char *readfilename, const char *tarfilename,
 	{
 		size_t		remaining = statbuf->st_size - len;
 
+		/* Keep the kernel reading ahead of us. */
+		basebackup_prefetch_file(fd, &prefetched, len, statbuf->st_size);
+
 		/* Try to read some more data. */
 		cnt = basebackup_read_file(fd, sink->bbs_buffer,
 								   Min(sink->bbs_buffer_length, remaining),
@@ -1811,6 +1818,47 @@ convert_link_to_directory(const char *pathbuf, struct stat *statbuf)
 		statbuf->st_mode = S_IFDIR | pg_dir_create_mode;
 }
 
+/*
+ * Ask the kernel to start reading the part of a file we'll want next.
+ *
+ * A base backup reads each file front to back with a single process, so
+ * while we're busy checksumming, compressing and sending one buffer the
+ * storage sits idle unless someone tells it what's coming.  We keep up to
+ * maintenance_io_concurrency sink buffers' worth of data requested ahead of
+ * the read position, issuing the advice in chunks of that size so that the
+ * number of system calls stays small.  *prefetched tracks how far we have
+ * already advised; the caller should initialize it to zero.
+ *
+ * This is only a hint, so failures are ignored.
+ */
+static void
+basebackup_prefetch_file(int fd, off_t *prefetched, off_t offset,
+						 off_t filesize)
+{
+#if defined(USE_POSIX_FADVISE) && defined(POSIX_FADV_WILLNEED)
+	off_t		distance;
+	off_t		nbytes;
+
+	if (maintenance_io_concurrency <= 0)
+		return;
+
+	distance = (off_t) maintenance_io_concurrency * SINK_BUFFER_LENGTH;
+
+	/* Nothing to do until we're within half the distance of the horizon. */
+	if (*prefetched >= filesize || *prefetched - offset > distance / 2)
+		return;
+
+	*prefetched = Max(*prefetched, offset);
+	nbytes = Min(distance, filesize - *prefetched);
+
+	pgstat_report_wait_start(WAIT_EVENT_BASEBACKUP_READ);
+	(void) posix_fadvise(fd, *prefetched, nbytes, POSIX_FADV_WILLNEED);
+	pgstat_report_wait_end();
+
+	*prefetched += nbytes;
+#endif
+}
+
 /*
  * Read some data from a file, setting a wait event and reporting any error
  * encountered.
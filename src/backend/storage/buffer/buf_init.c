@@ -23,6 +23,7 @@ char	   *BufferBlocks;
 ConditionVariableMinimallyPadded *BufferIOCVArray;
 WritebackContext BackendWritebackContext;
 CkptSortItem *CkptBufferIds;
+pg_atomic_uint32 *BufferDirtyMap;
 
 
 /*
@@ -70,7 +71,8 @@ InitBufferPool(void)
 	bool		foundBufs,
 				foundDescs,
 				foundIOCV,
-				foundBufCkpt;
+				foundBufCkpt,
+				foundDirtyMap;
 
 	/* Align descriptors to a cacheline boundary. */
 	BufferDescriptors = (BufferDescPadded *)
@@ -78,9 +80,12 @@ InitBufferPool(void)
 						NBuffers * sizeof(BufferDescPadded),
 						&foundDescs);
 
+	/* Align buffer pool on IO page size boundary, for direct I/O. */
 	BufferBlocks = (char *)
-		ShmemInitStruct("Buffer Blocks",
-						NBuffers * (Size) BLCKSZ, &foundBufs);
+		TYPEALIGN(PG_IO_ALIGN_SIZE,
+				  ShmemInitStruct("Buffer Blocks",
+								  NBuffers * (Size) BLCKSZ + PG_IO_ALIGN_SIZE,
+								  &foundBufs));
 
 	/* Align condition variables to cacheline boundary. */
 	BufferIOCVArray = (ConditionVariableMinimallyPadded *)
@@ -99,10 +104,16 @@ InitBufferPool(void)
 		ShmemInitStruct("Checkpoint BufferIds",
 						NBuffers * sizeof(CkptSortItem), &foundBufCkpt);
 
-	if (foundDescs || foundBufs || foundIOCV || foundBufCkpt)
+	BufferDirtyMap = (pg_atomic_uint32 *)
+		ShmemInitStruct("Buffer Dirty Map",
+						DirtyMapWords() * sizeof(pg_atomic_uint32),
+						&foundDirtyMap);
+
+	if (foundDescs || foundBufs || foundIOCV || foundBufCkpt || foundDirtyMap)
 	{
 		/* should find all of these, or none of them */
-		Assert(foundDescs && foundBufs && foundIOCV && foundBufCkpt);
+		Assert(foundDescs && foundBufs && foundIOCV && foundBufCkpt &&
+			   foundDirtyMap);
 		/* note: this path is only taken in EXEC_BACKEND case */
 	}
 	else
@@ -137,6 +148,10 @@ InitBufferPool(void)
 
 		/* Correct last entry of linked list */
 		GetBufferDescriptor(NBuffers - 1)->freeNext = FREENEXT_END_OF_LIST;
+
+		/* No buffer is dirty yet */
+		for (i = 0; i < DirtyMapWords(); i++)
+			pg_atomic_init_u32(&BufferDirtyMap[i], 0);
 	}
 
 	/* Init other shared buffer-management stuff */
@@ -163,7 +178,8 @@ BufferShmemSize(void)
 	/* to allow aligning buffer descriptors */
 	size = add_size(size, PG_CACHE_LINE_SIZE);
 
-	/* size of data pages */
+	/* size of data pages, plus alignment padding */
+	size = add_size(size, PG_IO_ALIGN_SIZE);
 	size = add_size(size, mul_size(NBuffers, BLCKSZ));
 
 	/* size of stuff controlled by freelist.c */
@@ -178,5 +194,8 @@ BufferShmemSize(void)
 	/* size of checkpoint sort array in bufmgr.c */
 	size = add_size(size, mul_size(NBuffers, sizeof(CkptSortItem)));
 
+	/* size of dirty buffer map */
+	size = add_size(size, mul_size(DirtyMapWords(), sizeof(pg_atomic_uint32)));
+
 	return size;
 }
@@ -44,6 +44,8 @@
 #include "miscadmin.h"
 #include "pg_trace.h"
 #include "pgstat.h"
+#include "port/pg_bitutils.h"
+#include "port/pg_iovec.h"
 #include "postmaster/bgwriter.h"
 #include "storage/buf_internals.h"
 #include "storage/bufmgr.h"
@@ -52,6 +54,7 @@
 #include "storage/smgr.h"
 #include "storage/standby.h"
 #include "utils/memdebug.h"
+#include "utils/memutils.h"
 #include "utils/ps_status.h"
 #include "utils/rel.h"
 #include "utils/resowner_private.h"
@@ -66,6 +69,9 @@
 #define LocalBufHdrGetBlock(bufHdr) \
 	LocalBufferBlockPointers[-((bufHdr)->buf_id + 2)]
 
+/* Maximum number of consecutive blocks BufferSync() writes at once */
+#define MAX_CHECKPOINT_WRITE_RUN	PG_IOV_MAX
+
 /* Bits in SyncOneBuffer's return value */
 #define BUF_WRITTEN				0x01
 #define BUF_REUSABLE			0x02
@@ -159,10 +165,18 @@ int			checkpoint_flush_after = 0;
 int			bgwriter_flush_after = 0;
 int			backend_flush_after = 0;
 
-/* local state for StartBufferIO and related functions */
-static BufferDesc *InProgressBuf = NULL;
+/*
+ * local state for StartBufferIO and related functions.  Normally at most one
+ * buffer is in the array, but SyncBufferRun() holds I/O on a whole run of
+ * buffers that it writes together.
+ */
+static BufferDesc *InProgressBufs[MAX_CHECKPOINT_WRITE_RUN];
+static int	NumInProgressBufs = 0;
 static bool IsForInput;
 
+/* private page copies for the run being written by SyncBufferRun() */
+static char *CheckpointRunPages = NULL;
+
 /* local state for LockBufferForCleanup */
 static BufferDesc *PinCountWaitBuf = NULL;
 
@@ -468,6 +482,8 @@ static void PinBuffer_Locked(BufferDesc *buf);
 static void UnpinBuffer(BufferDesc *buf, bool fixOwner);
 static void BufferSync(int flags);
 static uint32 WaitBufHdrUnlocked(BufferDesc *buf);
+static int	SyncBufferRun(CkptSortItem *items, int nitems, int *nwritten,
+						  WritebackContext *wb_context);
 static int	SyncOneBuffer(int buf_id, bool skip_recently_used,
 						  WritebackContext *wb_context);
 static void WaitIO(BufferDesc *buf);
@@ -1608,10 +1624,13 @@ MarkBufferDirty(Buffer buffer)
 	}
 
 	/*
-	 * If the buffer was not dirty already, do vacuum accounting.
+	 * If the buffer was not dirty already, record that in the dirty buffer
+	 * map and do vacuum accounting.
 	 */
 	if (!(old_buf_state & BM_DIRTY))
 	{
+		BufferDirtyMapSet(bufHdr->buf_id);
+
 		VacuumPageDirty++;
 		pgBufferUsage.shared_blks_dirtied++;
 		if (VacuumCostActive)
@@ -1946,6 +1965,7 @@ BufferSync(int flags)
 	int			num_spaces;
 	int			num_processed;
 	int			num_written;
+	int			nconsumed;
 	CkptTsStatus *per_ts_stat = NULL;
 	Oid			last_tsid;
 	binaryheap *ts_heap;
@@ -1980,33 +2000,57 @@ BufferSync(int flags)
 	 * Note that if we fail to write some buffer, we may leave buffers with
 	 * BM_CHECKPOINT_NEEDED still set.  This is OK since any such buffer would
 	 * certainly need to be written for the next checkpoint attempt, too.
+	 *
+	 * Only buffers whose bit is set in the dirty buffer map can be dirty, so
+	 * we look at those only.  Each word of the map is reset before examining
+	 * its buffers, and the bits of those still dirty are set again.  A buffer
+	 * that is dirtied concurrently either is seen dirty by us, or gets its
+	 * bit set by whoever dirtied it after we reset the word, so no dirty
+	 * buffer ever loses its bit.
 	 */
 	num_to_scan = 0;
-	for (buf_id = 0; buf_id < NBuffers; buf_id++)
+	for (i = 0; i < DirtyMapWords(); i++)
 	{
-		BufferDesc *bufHdr = GetBufferDescriptor(buf_id);
+		uint32		bits = pg_atomic_exchange_u32(&BufferDirtyMap[i], 0);
+		uint32		still_dirty = 0;
 
-		/*
-		 * Header spinlock is enough to examine BM_DIRTY, see comment in
-		 * SyncOneBuffer.
-		 */
-		buf_state = LockBufHdr(bufHdr);
-
-		if ((buf_state & mask) == mask)
+		while (bits != 0)
 		{
-			CkptSortItem *item;
+			int			bit = pg_rightmost_one_pos32(bits);
+			BufferDesc *bufHdr;
+
+			bits &= bits - 1;
+			buf_id = i * BUFFERS_PER_DIRTY_MAP_WORD + bit;
+			bufHdr = GetBufferDescriptor(buf_id);
+
+			/*
+			 * Header spinlock is enough to examine BM_DIRTY, see comment in
+			 * SyncOneBuffer.
+			 */
+			buf_state = LockBufHdr(bufHdr);
+
+			if (buf_state & BM_DIRTY)
+				still_dirty |= ((uint32) 1) << bit;
 
-			buf_state |= BM_CHECKPOINT_NEEDED;
+			if ((buf_state & mask) == mask)
+			{
+				CkptSortItem *item;
+
+				buf_state |= BM_CHECKPOINT_NEEDED;
 
-			item = &CkptBufferIds[num_to_scan++];
-			item->buf_id = buf_id;
-			item->tsId = bufHdr->tag.rnode.spcNode;
-			item->relNode = bufHdr->tag.rnode.relNode;
-			item->forkNum = bufHdr->tag.forkNum;
-			item->blockNum = bufHdr->tag.blockNum;
+				item = &CkptBufferIds[num_to_scan++];
+				item->buf_id = buf_id;
+				item->tsId = bufHdr->tag.rnode.spcNode;
+				item->relNode = bufHdr->tag.rnode.relNode;
+				item->forkNum = bufHdr->tag.forkNum;
+				item->blockNum = bufHdr->tag.blockNum;
+			}
+
+			UnlockBufHdr(bufHdr, buf_state);
 		}
 
-		UnlockBufHdr(bufHdr, buf_state);
+		if (still_dirty != 0)
+			pg_atomic_fetch_or_u32(&BufferDirtyMap[i], still_dirty);
 
 		/* Check for barrier events in case NBuffers is large. */
 		if (ProcSignalBarrierPending)
@@ -2135,7 +2179,7 @@ BufferSync(int flags)
 
 		bufHdr = GetBufferDescriptor(buf_id);
 
-		num_processed++;
+		nconsumed = 1;
 
 		/*
 		 * We don't need to acquire the lock here, because we're only looking
@@ -2151,21 +2195,54 @@ BufferSync(int flags)
 		 */
 		if (pg_atomic_read_u32(&bufHdr->state) & BM_CHECKPOINT_NEEDED)
 		{
-			if (SyncOneBuffer(buf_id, false, &wb_context) & BUF_WRITTEN)
+			CkptSortItem *run = &CkptBufferIds[ts_stat->index];
+			int			nrun = 1;
+
+			/*
+			 * As the array is sorted, dirty buffers holding consecutive
+			 * blocks of the same relation fork are adjacent.  Collect them
+			 * so that they can be written with a single write call.  The
+			 * sort key lacks the database, so SyncBufferRun() rechecks the
+			 * buffer tags.
+			 */
+			while (nrun < MAX_CHECKPOINT_WRITE_RUN &&
+				   ts_stat->num_scanned + nrun < ts_stat->num_to_scan &&
+				   run[nrun].relNode == run[0].relNode &&
+				   run[nrun].forkNum == run[0].forkNum &&
+				   run[nrun].blockNum == run[0].blockNum + nrun)
+				nrun++;
+
+			if (nrun == 1)
 			{
-				TRACE_POSTGRESQL_BUFFER_SYNC_WRITTEN(buf_id);
-				PendingCheckpointerStats.buf_written_checkpoints++;
-				num_written++;
+				if (SyncOneBuffer(buf_id, false, &wb_context) & BUF_WRITTEN)
+				{
+					TRACE_POSTGRESQL_BUFFER_SYNC_WRITTEN(buf_id);
+					PendingCheckpointerStats.buf_written_checkpoints++;
+					num_written++;
+				}
+			}
+			else
+			{
+				int			nwritten;
+
+				nconsumed = SyncBufferRun(run, nrun, &nwritten, &wb_context);
+
+				for (i = 0; i < nwritten; i++)
+					TRACE_POSTGRESQL_BUFFER_SYNC_WRITTEN(run[i].buf_id);
+				PendingCheckpointerStats.buf_written_checkpoints += nwritten;
+				num_written += nwritten;
 			}
 		}
 
+		num_processed += nconsumed;
+
 		/*
 		 * Measure progress independent of actually having to flush the buffer
 		 * - otherwise writing become unbalanced.
 		 */
-		ts_stat->progress += ts_stat->progress_slice;
-		ts_stat->num_scanned++;
-		ts_stat->index++;
+		ts_stat->progress += ts_stat->progress_slice * nconsumed;
+		ts_stat->num_scanned += nconsumed;
+		ts_stat->index += nconsumed;
 
 		/* Have all the buffers from the tablespace been processed? */
 		if (ts_stat->num_scanned == ts_stat->num_to_scan)
@@ -2500,6 +2577,188 @@ BgBufferSync(WritebackContext *wb_context)
 	return (bufs_to_lap == 0 && recent_alloc == 0);
 }
 
+/*
+ * SyncBufferRun -- write a run of checkpoint buffers with one write call.
+ *
+ * items[] are consecutive entries of the sorted checkpoint array, which the
+ * caller believes to hold consecutive blocks of one relation fork.  Starting
+ * with items[0], we pin each buffer that still needs to be checkpointed,
+ * start I/O on it and copy its contents to private storage, then flush WAL
+ * once up to the highest LSN seen and write all the copies out together.
+ * Holding BM_IO_IN_PROGRESS keeps anyone else from writing the buffers
+ * meanwhile, so we don't have to keep the content locks during the write.
+ *
+ * The run ends early at the first buffer that doesn't continue it, or whose
+ * content lock can't be acquired without waiting; we never wait for a lock
+ * while holding I/O on other buffers.  Returns the number of items consumed,
+ * which is at least one, and sets *nwritten to the number of buffers
+ * written, which are the first ones of the consumed items.
+ */
+static int
+SyncBufferRun(CkptSortItem *items, int nitems, int *nwritten,
+			  WritebackContext *wb_context)
+{
+	BufferDesc *bufs[MAX_CHECKPOINT_WRITE_RUN];
+	char	   *pages[MAX_CHECKPOINT_WRITE_RUN];
+	BufferTag	tag;
+	XLogRecPtr	max_lsn = InvalidXLogRecPtr;
+	SMgrRelation reln;
+	ErrorContextCallback errcallback;
+	instr_time	io_start,
+				io_time;
+	int			nbufs = 0;
+	int			i;
+
+	Assert(nitems > 0 && nitems <= MAX_CHECKPOINT_WRITE_RUN);
+
+	*nwritten = 0;
+
+	if (CheckpointRunPages == NULL)
+		CheckpointRunPages = (char *)
+			TYPEALIGN(PG_IO_ALIGN_SIZE,
+					  MemoryContextAlloc(TopMemoryContext,
+										 MAX_CHECKPOINT_WRITE_RUN * BLCKSZ +
+										 PG_IO_ALIGN_SIZE));
+
+	while (nbufs < nitems)
+	{
+		BufferDesc *bufHdr = GetBufferDescriptor(items[nbufs].buf_id);
+		LWLock	   *content_lock = BufferDescriptorGetContentLock(bufHdr);
+		uint32		buf_state;
+		XLogRecPtr	lsn;
+
+		ResourceOwnerEnlargeBuffers(CurrentResourceOwner);
+		ReservePrivateRefCountEntry();
+
+		buf_state = LockBufHdr(bufHdr);
+
+		if (!(buf_state & BM_VALID) || !(buf_state & BM_DIRTY) ||
+			!(buf_state & BM_CHECKPOINT_NEEDED))
+		{
+			/* It's clean, or was already written for this checkpoint */
+			UnlockBufHdr(bufHdr, buf_state);
+			break;
+		}
+
+		if (nbufs == 0)
+			tag = bufHdr->tag;
+		else if ((buf_state & BM_IO_IN_PROGRESS) ||
+				 !RelFileNodeEquals(bufHdr->tag.rnode, tag.rnode) ||
+				 bufHdr->tag.forkNum != tag.forkNum ||
+				 bufHdr->tag.blockNum != tag.blockNum + nbufs)
+		{
+			UnlockBufHdr(bufHdr, buf_state);
+			break;
+		}
+
+		PinBuffer_Locked(bufHdr);
+
+		if (nbufs == 0)
+			LWLockAcquire(content_lock, LW_SHARED);
+		else if (!LWLockConditionalAcquire(content_lock, LW_SHARED))
+		{
+			UnpinBuffer(bufHdr, true);
+			break;
+		}
+
+		if (!StartBufferIO(bufHdr, false))
+		{
+			/* someone else wrote it meanwhile */
+			LWLockRelease(content_lock);
+			UnpinBuffer(bufHdr, true);
+			break;
+		}
+
+		/* See FlushBuffer() for why the header lock is needed here */
+		buf_state = LockBufHdr(bufHdr);
+		lsn = BufferGetLSN(bufHdr);
+		buf_state &= ~BM_JUST_DIRTIED;
+		UnlockBufHdr(bufHdr, buf_state);
+
+		/* Only permanent buffers need WAL flushed, see FlushBuffer() */
+		if ((buf_state & BM_PERMANENT) && lsn > max_lsn)
+			max_lsn = lsn;
+
+		/*
+		 * Take a private copy to write out; once we have it, the content
+		 * lock can be released.  Any change made to the page from now on
+		 * sets BM_JUST_DIRTIED, which keeps the buffer dirty.
+		 */
+		pages[nbufs] = CheckpointRunPages + (Size) nbufs * BLCKSZ;
+		memcpy(pages[nbufs], BufHdrGetBlock(bufHdr), BLCKSZ);
+		LWLockRelease(content_lock);
+
+		PageSetChecksumInplace((Page) pages[nbufs], tag.blockNum + nbufs);
+
+		bufs[nbufs++] = bufHdr;
+	}
+
+	if (nbufs == 0)
+		return 1;
+
+	/* Setup error traceback support for ereport() */
+	errcallback.callback = shared_buffer_write_error_callback;
+	errcallback.arg = (void *) bufs[0];
+	errcallback.previous = error_context_stack;
+	error_context_stack = &errcallback;
+
+	reln = smgropen(tag.rnode, InvalidBackendId);
+
+	for (i = 0; i < nbufs; i++)
+		TRACE_POSTGRESQL_BUFFER_FLUSH_START(tag.forkNum,
+											tag.blockNum + i,
+											reln->smgr_rnode.node.spcNode,
+											reln->smgr_rnode.node.dbNode,
+											reln->smgr_rnode.node.relNode);
+
+	/* One WAL flush covers the whole run */
+	if (max_lsn != InvalidXLogRecPtr)
+		XLogFlush(max_lsn);
+
+	if (track_io_timing)
+		INSTR_TIME_SET_CURRENT(io_start);
+
+	smgrwritev(reln, tag.forkNum, tag.blockNum, pages, nbufs, false);
+
+	if (track_io_timing)
+	{
+		INSTR_TIME_SET_CURRENT(io_time);
+		INSTR_TIME_SUBTRACT(io_time, io_start);
+		pgstat_count_buffer_write_time(INSTR_TIME_GET_MICROSEC(io_time));
+		INSTR_TIME_ADD(pgBufferUsage.blk_write_time, io_time);
+	}
+
+	pgBufferUsage.shared_blks_written += nbufs;
+
+	for (i = 0; i < nbufs; i++)
+	{
+		TerminateBufferIO(bufs[i], true, 0);
+
+		TRACE_POSTGRESQL_BUFFER_FLUSH_DONE(tag.forkNum,
+										   tag.blockNum + i,
+										   reln->smgr_rnode.node.spcNode,
+										   reln->smgr_rnode.node.dbNode,
+										   reln->smgr_rnode.node.relNode);
+	}
+
+	/* Pop the error context stack */
+	error_context_stack = errcallback.previous;
+
+	for (i = 0; i < nbufs; i++)
+	{
+		BufferTag	blocktag = tag;
+
+		UnpinBuffer(bufs[i], true);
+
+		blocktag.blockNum = tag.blockNum + i;
+		ScheduleBufferTagForWriteback(wb_context, &blocktag);
+	}
+
+	*nwritten = nbufs;
+
+	return nbufs;
+}
+
 /*
  * SyncOneBuffer -- process a single buffer during syncing.
  *
@@ -4102,6 +4361,15 @@ MarkBufferDirtyHint(Buffer buffer, bool buffer_std)
 		buf_state |= BM_DIRTY | BM_JUST_DIRTIED;
 		UnlockBufHdr(bufHdr, buf_state);
 
+		/*
+		 * The buffer must be in the dirty buffer map before we let a
+		 * checkpoint start.  Otherwise BufferSync could drain the map in
+		 * between and skip this buffer, although its full-page image was
+		 * logged before the checkpoint's redo pointer.
+		 */
+		if (dirtied)
+			BufferDirtyMapSet(bufHdr->buf_id);
+
 		if (delayChkptFlags)
 			MyProc->delayChkptFlags &= ~DELAY_CHKPT_START;
 
@@ -4487,8 +4755,9 @@ IsBufferCleanupOK(Buffer buffer)
 /*
  *	Functions for buffer I/O handling
  *
- *	Note: We assume that nested buffer I/O never occurs.
- *	i.e at most one BM_IO_IN_PROGRESS bit is set per proc.
+ *	Note: We assume that nested buffer I/O never occurs, i.e. at most one
+ *	BM_IO_IN_PROGRESS bit is set per proc, except for the output runs of
+ *	SyncBufferRun().
  *
  *	Also note that these are used only for shared buffers, not local ones.
  */
@@ -4544,7 +4813,9 @@ StartBufferIO(BufferDesc *buf, bool forInput)
 {
 	uint32		buf_state;
 
-	Assert(!InProgressBuf);
+	/* Only output I/O may be done on several buffers at once */
+	Assert(NumInProgressBufs == 0 || (!forInput && !IsForInput));
+	Assert(NumInProgressBufs < MAX_CHECKPOINT_WRITE_RUN);
 
 	for (;;)
 	{
@@ -4568,7 +4839,7 @@ StartBufferIO(BufferDesc *buf, bool forInput)
 	buf_state |= BM_IO_IN_PROGRESS;
 	UnlockBufHdr(buf, buf_state);
 
-	InProgressBuf = buf;
+	InProgressBufs[NumInProgressBufs++] = buf;
 	IsForInput = forInput;
 
 	return true;
@@ -4594,8 +4865,14 @@ static void
 TerminateBufferIO(BufferDesc *buf, bool clear_dirty, uint32 set_flag_bits)
 {
 	uint32		buf_state;
+	int			i;
 
-	Assert(buf == InProgressBuf);
+	for (i = NumInProgressBufs - 1; i >= 0; i--)
+	{
+		if (InProgressBufs[i] == buf)
+			break;
+	}
+	Assert(i >= 0);
 
 	buf_state = LockBufHdr(buf);
 
@@ -4608,7 +4885,7 @@ TerminateBufferIO(BufferDesc *buf, bool clear_dirty, uint32 set_flag_bits)
 	buf_state |= set_flag_bits;
 	UnlockBufHdr(buf, buf_state);
 
-	InProgressBuf = NULL;
+	InProgressBufs[i] = InProgressBufs[--NumInProgressBufs];
 
 	ConditionVariableBroadcast(BufferDescriptorGetIOCV(buf));
 }
@@ -4625,10 +4902,9 @@ TerminateBufferIO(BufferDesc *buf, bool clear_dirty, uint32 set_flag_bits)
 void
 AbortBufferIO(void)
 {
-	BufferDesc *buf = InProgressBuf;
-
-	if (buf)
+	while (NumInProgressBufs > 0)
 	{
+		BufferDesc *buf = InProgressBufs[NumInProgressBufs - 1];
 		uint32		buf_state;
 
 		buf_state = LockBufHdr(buf);
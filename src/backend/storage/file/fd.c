@@ -165,6 +165,9 @@ bool		data_sync_retry = false;
 /* How SyncDataDirectory() should do its job. */
 int			recovery_init_sync_method = RECOVERY_INIT_SYNC_METHOD_FSYNC;
 
+/* Which kinds of files are opened with PG_O_DIRECT (debug_io_direct). */
+int			io_direct_flags;
+
 /* Debugging.... */
 
 #ifdef FDDEBUG
@@ -2167,16 +2170,41 @@ retry:
 int
 FileWrite(File file, char *buffer, int amount, off_t offset,
 		  uint32 wait_event_info)
+{
+	struct iovec iov;
+
+	iov.iov_base = buffer;
+	iov.iov_len = amount;
+
+	return FileWriteV(file, &iov, 1, offset, wait_event_info);
+}
+
+/*
+ * FileWriteV --- write data from several buffers to consecutive file
+ * locations with a single system call.
+ *
+ * Returns the number of bytes written, or -1 with errno set.  As with
+ * FileWrite(), a short write is reported to the caller rather than retried.
+ */
+int
+FileWriteV(File file, const struct iovec *iov, int iovcnt, off_t offset,
+		   uint32 wait_event_info)
 {
 	int			returnCode;
+	int			amount;
 	Vfd		   *vfdP;
 
 	Assert(FileIsValid(file));
+	Assert(iovcnt > 0);
+
+	amount = 0;
+	for (int i = 0; i < iovcnt; i++)
+		amount += iov[i].iov_len;
 
-	DO_DB(elog(LOG, "FileWrite: %d (%s) " INT64_FORMAT " %d %p",
+	DO_DB(elog(LOG, "FileWriteV: %d (%s) " INT64_FORMAT " %d %d",
 			   file, VfdCache[file].fileName,
 			   (int64) offset,
-			   amount, buffer));
+			   amount, iovcnt));
 
 	returnCode = FileAccess(file);
 	if (returnCode < 0)
@@ -2212,7 +2240,7 @@ FileWrite(File file, char *buffer, int amount, off_t offset,
 retry:
 	errno = 0;
 	pgstat_report_wait_start(wait_event_info);
-	returnCode = pg_pwrite(VfdCache[file].fd, buffer, amount, offset);
+	returnCode = pg_pwritev(VfdCache[file].fd, iov, iovcnt, offset);
 	pgstat_report_wait_end();
 
 	/* if write didn't set errno, assume problem is no disk space */
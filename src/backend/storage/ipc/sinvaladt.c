@@ -175,6 +175,13 @@ typedef struct SISeg
 	int			lastBackend;	/* index of last active procState entry, +1 */
 	int			maxBackends;	/* size of procState array */
 
+	/*
+	 * Total number of messages ever inserted.  Unlike maxMsgNum this never
+	 * wraps around, so it tells whether any message has been queued since it
+	 * was last looked at.  Same locking rules as maxMsgNum.
+	 */
+	uint64		totalMsgs;
+
 	slock_t		msgnumLock;		/* spinlock protecting maxMsgNum */
 
 	/*
@@ -238,6 +245,7 @@ CreateSharedInvalidationState(void)
 	/* Clear message counters, save size of procState array, init spinlock */
 	shmInvalBuffer->minMsgNum = 0;
 	shmInvalBuffer->maxMsgNum = 0;
+	shmInvalBuffer->totalMsgs = 0;
 	shmInvalBuffer->nextThreshold = CLEANUP_MIN;
 	shmInvalBuffer->lastBackend = 0;
 	shmInvalBuffer->maxBackends = MaxBackends;
@@ -492,6 +500,7 @@ SIInsertDataEntries(const SharedInvalidationMessage *data, int n)
 
 		/* Update current value of maxMsgNum using spinlock */
 		SpinLockAcquire(&segP->msgnumLock);
+		segP->totalMsgs += max - segP->maxMsgNum;
 		segP->maxMsgNum = max;
 		SpinLockRelease(&segP->msgnumLock);
 
@@ -513,6 +522,27 @@ SIInsertDataEntries(const SharedInvalidationMessage *data, int n)
 	}
 }
 
+/*
+ * SIGetTotalMessages
+ *		Return the number of messages ever added to the buffer
+ *
+ * A caller that reads this before absorbing invalidation messages can later
+ * compare the value to find out whether any message has been sent since,
+ * including ones it may not have processed yet.
+ */
+uint64
+SIGetTotalMessages(void)
+{
+	SISeg	   *segP = shmInvalBuffer;
+	uint64		result;
+
+	SpinLockAcquire(&segP->msgnumLock);
+	result = segP->totalMsgs;
+	SpinLockRelease(&segP->msgnumLock);
+
+	return result;
+}
+
 /*
  * SIGetDataEntries
  *		get next SI message(s) for current backend, if there are any
@@ -183,6 +183,10 @@ static const char *const BuiltinTrancheNames[] = {
 	"PgStatsHash",
 	/* LWTRANCHE_PGSTATS_DATA: */
 	"PgStatsData",
+	/* LWTRANCHE_SHARED_PLAN_CACHE: */
+	"SharedPlanCache",
+	/* LWTRANCHE_SHARED_PLAN_CACHE_DSA: */
+	"SharedPlanCacheDSA",
 };
 
 StaticAssertDecl(lengthof(BuiltinTrancheNames) ==
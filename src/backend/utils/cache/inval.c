@@ -125,6 +125,7 @@
 #include "utils/memutils.h"
 #include "utils/rel.h"
 #include "utils/relmapper.h"
+#include "utils/sharedplancache.h"
 #include "utils/snapmgr.h"
 #include "utils/syscache.h"
 
@@ -995,6 +996,7 @@ ProcessCommittedInvalidationMessages(SharedInvalidationMessage *msgs,
 	}
 
 	SendSharedInvalidMessages(msgs, nmsgs);
+	SharedPlanCacheProcessMessages(msgs, nmsgs);
 
 	if (RelcacheInitFileInval)
 		RelationCacheInitFilePostInvalidate();
@@ -1050,6 +1052,14 @@ AtEOXact_Inval(bool isCommit)
 		ProcessInvalidationMessagesMulti(&transInvalInfo->PriorCmdInvalidMsgs,
 										 SendSharedInvalidMessages);
 
+		/*
+		 * Other backends leave the shared plan cache alone when they read
+		 * these messages, so remove any shared plans they affect ourselves.
+		 * See sharedplancache.c.
+		 */
+		ProcessInvalidationMessagesMulti(&transInvalInfo->PriorCmdInvalidMsgs,
+										 SharedPlanCacheProcessMessages);
+
 		if (transInvalInfo->RelcacheInitFileInval)
 			RelationCacheInitFilePostInvalidate();
 	}
@@ -1192,6 +1202,22 @@ CommandEndInvalidationMessages(void)
 }
 
 
+/*
+ * xactHasPendingInvalidations
+ *		Has the current transaction registered invalidation messages that it
+ *		has not sent yet?
+ *
+ * This is true as soon as the transaction has modified a catalog, and stays
+ * true until it ends.  Anything built from catalog state visible to such a
+ * transaction may not be valid for other backends.
+ */
+bool
+xactHasPendingInvalidations(void)
+{
+	return transInvalInfo != NULL;
+}
+
+
 /*
  * CacheInvalidateHeapTuple
  *		Register the given tuple for invalidation at end of command
@@ -58,6 +58,7 @@
 
 #include "access/transam.h"
 #include "catalog/namespace.h"
+#include "executor/execPartition.h"
 #include "executor/executor.h"
 #include "miscadmin.h"
 #include "nodes/nodeFuncs.h"
@@ -71,6 +72,7 @@
 #include "utils/memutils.h"
 #include "utils/resowner_private.h"
 #include "utils/rls.h"
+#include "utils/sharedplancache.h"
 #include "utils/snapmgr.h"
 #include "utils/syscache.h"
 
@@ -99,14 +101,18 @@ static dlist_head cached_expression_list = DLIST_STATIC_INIT(cached_expression_l
 static void ReleaseGenericPlan(CachedPlanSource *plansource);
 static List *RevalidateCachedQuery(CachedPlanSource *plansource,
 								   QueryEnvironment *queryEnv);
-static bool CheckCachedPlan(CachedPlanSource *plansource);
+static bool CheckCachedPlan(CachedPlanSource *plansource,
+							ParamListInfo boundParams);
 static CachedPlan *BuildCachedPlan(CachedPlanSource *plansource, List *qlist,
 								   ParamListInfo boundParams, QueryEnvironment *queryEnv);
 static bool choose_custom_plan(CachedPlanSource *plansource,
 							   ParamListInfo boundParams);
 static double cached_plan_cost(CachedPlan *plan, bool include_planner);
 static Query *QueryListGetPrimaryStmt(List *stmts);
-static void AcquireExecutorLocks(List *stmt_list, bool acquire);
+static List *AcquireExecutorLocks(CachedPlan *plan, ParamListInfo boundParams);
+static void ReleaseExecutorLocks(List *stmt_list, List *leaflocks);
+static void LockPlannedStmtRels(PlannedStmt *plannedstmt, Bitmapset *relids,
+								bool skip, bool acquire);
 static void AcquirePlannerLocks(List *stmt_list, bool acquire);
 static void ScanQueryForLocks(Query *parsetree, bool acquire);
 static bool ScanQueryWalker(Node *node, bool *acquire);
@@ -121,11 +127,13 @@ int			plan_cache_mode;
 /*
  * InitPlanCache: initialize module during InitPostgres.
  *
- * All we need to do is hook into inval.c's callback lists.
+ * All we need to do is hook into inval.c's callback lists, and attach to the
+ * shared plan cache if it's enabled.
  */
 void
 InitPlanCache(void)
 {
+	/* keep SharedPlanCacheProcessMessages() in sync with these */
 	CacheRegisterRelcacheCallback(PlanCacheRelCallback, (Datum) 0);
 	CacheRegisterSyscacheCallback(PROCOID, PlanCacheObjectCallback, (Datum) 0);
 	CacheRegisterSyscacheCallback(TYPEOID, PlanCacheObjectCallback, (Datum) 0);
@@ -134,6 +142,8 @@ InitPlanCache(void)
 	CacheRegisterSyscacheCallback(AMOPOPID, PlanCacheSysCallback, (Datum) 0);
 	CacheRegisterSyscacheCallback(FOREIGNSERVEROID, PlanCacheSysCallback, (Datum) 0);
 	CacheRegisterSyscacheCallback(FOREIGNDATAWRAPPEROID, PlanCacheSysCallback, (Datum) 0);
+
+	SharedPlanCacheAttach();
 }
 
 /*
@@ -790,11 +800,15 @@ RevalidateCachedQuery(CachedPlanSource *plansource,
  *
  * On a "true" return, we have acquired the locks needed to run the plan.
  * (We must do this for the "true" result to be race-condition-free.)
+ * boundParams are the parameter values the plan is about to be executed
+ * with; they are used to avoid locking partitions that the executor's
+ * initial partition pruning will eliminate.
  */
 static bool
-CheckCachedPlan(CachedPlanSource *plansource)
+CheckCachedPlan(CachedPlanSource *plansource, ParamListInfo boundParams)
 {
 	CachedPlan *plan = plansource->gplan;
+	List	   *leaflocks;
 
 	/* Assert that caller checked the querytree */
 	Assert(plansource->is_valid);
@@ -826,7 +840,7 @@ CheckCachedPlan(CachedPlanSource *plansource)
 		 */
 		Assert(plan->refcount > 0);
 
-		AcquireExecutorLocks(plan->stmt_list, true);
+		leaflocks = AcquireExecutorLocks(plan, boundParams);
 
 		/*
 		 * If plan was transient, check to see if TransactionXmin has
@@ -848,7 +862,7 @@ CheckCachedPlan(CachedPlanSource *plansource)
 		}
 
 		/* Oops, the race case happened.  Release useless locks. */
-		AcquireExecutorLocks(plan->stmt_list, false);
+		ReleaseExecutorLocks(plan->stmt_list, leaflocks);
 	}
 
 	/*
@@ -885,6 +899,8 @@ BuildCachedPlan(CachedPlanSource *plansource, List *qlist,
 	bool		is_transient;
 	MemoryContext plan_context;
 	MemoryContext oldcxt = CurrentMemoryContext;
+	char	   *shared_key = NULL;
+	uint64		shared_generation = 0;
 	ListCell   *lc;
 
 	/*
@@ -903,6 +919,33 @@ BuildCachedPlan(CachedPlanSource *plansource, List *qlist,
 	if (!plansource->is_valid)
 		qlist = RevalidateCachedQuery(plansource, queryEnv);
 
+	/*
+	 * Another backend may already have made a generic plan for this query.
+	 * The shared cache's generation must be noted before absorbing any
+	 * pending invalidations, so that if we do the planning ourselves and the
+	 * result is already outdated by the time we publish it, that's detected;
+	 * see sharedplancache.c.  If the absorbed invalidations affect us, just
+	 * proceed the same as we would for an invalidation arriving during
+	 * planning, without involving the shared cache.  A transaction that has
+	 * modified catalogs sees a state that other backends don't, so it must
+	 * stay away from the shared cache altogether.
+	 */
+	plist = NIL;
+	if (boundParams == NULL && plansource->is_saved &&
+		!plansource->dependsOnRLS && SharedPlanCacheEnabled() &&
+		!xactHasPendingInvalidations())
+	{
+		shared_generation = SharedPlanCacheGeneration();
+		AcceptInvalidationMessages();
+		if (plansource->is_valid)
+		{
+			shared_key = SharedPlanCacheKey(plansource->query_list,
+											plansource->cursor_options);
+			if (shared_key != NULL)
+				plist = SharedPlanCacheLookup(shared_key);
+		}
+	}
+
 	/*
 	 * If we don't already have a copy of the querytree list that can be
 	 * scribbled on by the planner, make one.  For a one-shot plan, we assume
@@ -930,10 +973,17 @@ BuildCachedPlan(CachedPlanSource *plansource, List *qlist,
 	}
 
 	/*
-	 * Generate the plan.
+	 * Generate the plan, unless we found one above, and offer it to other
+	 * backends if it's eligible.
 	 */
-	plist = pg_plan_queries(qlist, plansource->query_string,
-							plansource->cursor_options, boundParams);
+	if (plist == NIL)
+	{
+		plist = pg_plan_queries(qlist, plansource->query_string,
+								plansource->cursor_options, boundParams);
+
+		if (shared_key != NULL)
+			SharedPlanCacheInsert(shared_key, plist, shared_generation);
+	}
 
 	/* Release snapshot if we got one */
 	if (snapshot_set)
@@ -1160,7 +1210,7 @@ GetCachedPlan(CachedPlanSource *plansource, ParamListInfo boundParams,
 
 	if (!customplan)
 	{
-		if (CheckCachedPlan(plansource))
+		if (CheckCachedPlan(plansource, boundParams))
 		{
 			/* We want a generic plan, and we already have a valid one */
 			plan = plansource->gplan;
@@ -1736,18 +1786,28 @@ QueryListGetPrimaryStmt(List *stmts)
 }
 
 /*
- * AcquireExecutorLocks: acquire locks needed for execution of a cached plan;
- * or release them if acquire is false.
+ * AcquireExecutorLocks: acquire locks needed for execution of a cached plan.
+ *
+ * Leaf partitions listed in a PlannedStmt's prunableRelids are locked only
+ * if they survive initial partition pruning with the given boundParams; the
+ * executor will repeat the pruning and never open the others.  With many
+ * partitions this saves most of the cost of starting up a generic plan.
+ * The partitioned tables themselves are always locked first, since pruning
+ * needs their partition descriptors.
+ *
+ * Returns a list, parallel to the plan's stmt_list, of the leaf partitions
+ * that were locked; pass it to ReleaseExecutorLocks to undo our work.
  */
-static void
-AcquireExecutorLocks(List *stmt_list, bool acquire)
+static List *
+AcquireExecutorLocks(CachedPlan *plan, ParamListInfo boundParams)
 {
+	List	   *leaflocks = NIL;
 	ListCell   *lc1;
 
-	foreach(lc1, stmt_list)
+	foreach(lc1, plan->stmt_list)
 	{
 		PlannedStmt *plannedstmt = lfirst_node(PlannedStmt, lc1);
-		ListCell   *lc2;
+		Bitmapset  *leafrelids;
 
 		if (plannedstmt->commandType == CMD_UTILITY)
 		{
@@ -1761,28 +1821,98 @@ AcquireExecutorLocks(List *stmt_list, bool acquire)
 			Query	   *query = UtilityContainsQuery(plannedstmt->utilityStmt);
 
 			if (query)
-				ScanQueryForLocks(query, acquire);
+				ScanQueryForLocks(query, true);
+			leaflocks = lappend(leaflocks, NULL);
 			continue;
 		}
 
-		foreach(lc2, plannedstmt->rtable)
-		{
-			RangeTblEntry *rte = (RangeTblEntry *) lfirst(lc2);
+		/* Lock everything except the prunable leaf partitions */
+		LockPlannedStmtRels(plannedstmt, plannedstmt->prunableRelids,
+							true, true);
 
-			if (rte->rtekind != RTE_RELATION)
-				continue;
+		/*
+		 * Now find out which leaf partitions survive pruning.  Don't bother
+		 * if the locks we just took revealed that the plan is stale; the
+		 * partition structures might no longer match it.
+		 */
+		leafrelids = plannedstmt->prunableRelids;
+		if (leafrelids != NULL && boundParams != NULL && plan->is_valid)
+			leafrelids = ExecGetUnprunedLeafRelids(plannedstmt, boundParams);
 
-			/*
-			 * Acquire the appropriate type of lock on each relation OID. Note
-			 * that we don't actually try to open the rel, and hence will not
-			 * fail if it's been dropped entirely --- we'll just transiently
-			 * acquire a non-conflicting lock.
-			 */
-			if (acquire)
-				LockRelationOid(rte->relid, rte->rellockmode);
-			else
-				UnlockRelationOid(rte->relid, rte->rellockmode);
+		LockPlannedStmtRels(plannedstmt, leafrelids, false, true);
+		leaflocks = lappend(leaflocks, leafrelids);
+	}
+
+	return leaflocks;
+}
+
+/*
+ * ReleaseExecutorLocks: release the locks taken by AcquireExecutorLocks.
+ */
+static void
+ReleaseExecutorLocks(List *stmt_list, List *leaflocks)
+{
+	ListCell   *lc1;
+	ListCell   *lc2;
+
+	forboth(lc1, stmt_list, lc2, leaflocks)
+	{
+		PlannedStmt *plannedstmt = lfirst_node(PlannedStmt, lc1);
+		Bitmapset  *leafrelids = (Bitmapset *) lfirst(lc2);
+
+		if (plannedstmt->commandType == CMD_UTILITY)
+		{
+			/* See comment in AcquireExecutorLocks */
+			Query	   *query = UtilityContainsQuery(plannedstmt->utilityStmt);
+
+			if (query)
+				ScanQueryForLocks(query, false);
+			continue;
 		}
+
+		LockPlannedStmtRels(plannedstmt, plannedstmt->prunableRelids,
+							true, false);
+		LockPlannedStmtRels(plannedstmt, leafrelids, false, false);
+	}
+}
+
+/*
+ * LockPlannedStmtRels: lock or unlock the relations of a PlannedStmt's
+ * range table whose RT indexes are in relids, or if skip is true, those
+ * that are not.
+ */
+static void
+LockPlannedStmtRels(PlannedStmt *plannedstmt, Bitmapset *relids,
+					bool skip, bool acquire)
+{
+	ListCell   *lc;
+	Index		rti = 0;
+
+	/* Quick exit if there's nothing to do */
+	if (!skip && relids == NULL)
+		return;
+
+	foreach(lc, plannedstmt->rtable)
+	{
+		RangeTblEntry *rte = (RangeTblEntry *) lfirst(lc);
+
+		rti++;
+
+		if (rte->rtekind != RTE_RELATION)
+			continue;
+		if (bms_is_member(rti, relids) == skip)
+			continue;
+
+		/*
+		 * Acquire the appropriate type of lock on each relation OID. Note
+		 * that we don't actually try to open the rel, and hence will not
+		 * fail if it's been dropped entirely --- we'll just transiently
+		 * acquire a non-conflicting lock.
+		 */
+		if (acquire)
+			LockRelationOid(rte->relid, rte->rellockmode);
+		else
+			UnlockRelationOid(rte->relid, rte->rellockmode);
 	}
 }
 
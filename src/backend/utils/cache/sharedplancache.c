@@ -0,0 +1,676 @@
+/*-------------------------------------------------------------------------
+ *
+ * sharedplancache.c
+ *	  Cross-backend cache of generic plans.
+ *
+ * plancache.c keeps every backend's generic plans private, so when many
+ * sessions prepare the same statements each of them plans each statement
+ * itself, and keeps its own copy of the result.  When shared_plan_cache_size
+ * is set, generic plans of saved statements are also published, in
+ * nodeToString() form, in an area of shared memory.  A backend about to build
+ * a generic plan first looks for one there, and if it finds one it just
+ * reads it back in rather than planning.
+ *
+ * Parse analysis and rewriting still happen in each backend, because their
+ * result depends on session state such as search_path.  The key for a plan
+ * starts with the analyzed and rewritten query tree itself, together with the
+ * cursor options and the planner-related settings (those marked GUC_EXPLAIN)
+ * that differ from their defaults.  That's not all the plan depends on,
+ * though: the planner parses and analyzes the bodies of SQL functions it
+ * inlines, under the current search_path and other parser settings, and
+ * skips inlining functions the current user may not execute.  So the key
+ * also includes the database, the current user, the effective search path
+ * and the settings that affect how the parser reads literals.  Only a hash
+ * of the key is stored in the hashtable; the full key is kept alongside the
+ * plan and compared on lookup, so a hash collision can never yield the wrong
+ * plan.  Statements whose plans depend on the current role (through
+ * row-level security) or that are transient are never shared, nor are
+ * utility statements.
+ *
+ * Each entry remembers the relations and the PROCOID/TYPEOID objects its plan
+ * depends on.  After queueing its invalidation messages at commit, a backend
+ * passes them to SharedPlanCacheProcessMessages, which removes the affected
+ * entries; during recovery, the startup process does the same for the
+ * messages it replays.  The backends that read the messages from the queue
+ * leave the shared cache alone.  With many backends, each of them scanning
+ * the whole hashtable for every catalog change would be far too expensive,
+ * and a backend that fell behind and had its queue reset would wipe the
+ * whole cache.
+ *
+ * Removing the entries at commit is not enough by itself: a backend may
+ * build a plan from catalog state that a concurrently committed change makes
+ * outdated, and try to publish it after the entries have been removed.  Since
+ * a transaction queues its invalidation messages only after its commit has
+ * become visible, plancache.c notes how many messages have ever been queued
+ * (the "generation") before absorbing pending invalidations and planning,
+ * and an entry is only added if no message has been queued since then.
+ * Either the plan saw the committed catalog state, or the messages of the
+ * commit are queued after the entry has been added, and will remove it.  A
+ * transaction that has modified catalogs itself neither publishes plans nor
+ * uses published ones, because its messages have not been queued yet.
+ *
+ * The cache has a fixed size.  Once it is full, further plans are simply not
+ * published until invalidations make room.
+ *
+ * Portions Copyright (c) 1996-2022, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * IDENTIFICATION
+ *	  src/backend/utils/cache/sharedplancache.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "catalog/namespace.h"
+#include "common/hashfn.h"
+#include "miscadmin.h"
+#include "nodes/parsenodes.h"
+#include "nodes/plannodes.h"
+#include "storage/ipc.h"
+#include "storage/lwlock.h"
+#include "storage/shmem.h"
+#include "storage/sinvaladt.h"
+#include "utils/dsa.h"
+#include "utils/guc.h"
+#include "utils/guc_tables.h"
+#include "utils/hsearch.h"
+#include "utils/memutils.h"
+#include "utils/sharedplancache.h"
+#include "utils/syscache.h"
+
+/*
+ * Rough size of the key and plan of a typical statement, in nodeToString()
+ * form.  Only used to size the hashtable.
+ */
+#define SPC_AVG_ENTRY_SIZE		(16 * 1024)
+
+/*
+ * Settings that are not marked GUC_EXPLAIN, but that affect how the planner
+ * parses the bodies of SQL functions it inlines.
+ */
+static const char *const spc_parser_gucs[] = {
+	"array_nulls",
+	"DateStyle",
+	"IntervalStyle",
+	"standard_conforming_strings",
+	"TimeZone",
+	"transform_null_equals"
+};
+
+/* Shared state of the cache */
+typedef struct SharedPlanCacheControl
+{
+	LWLock		lock;			/* protects the hashtable and its entries */
+	void	   *raw_dsa_area;	/* memory holding the keys and plans */
+} SharedPlanCacheControl;
+
+/* PlanInvalItem, as remembered by an entry */
+typedef struct SharedPlanInvalItem
+{
+	int			cacheId;
+	uint32		hashValue;
+} SharedPlanInvalItem;
+
+/* Hashtable entry */
+typedef struct SharedPlanCacheEntry
+{
+	uint64		hashkey;		/* hash of the key string: must be first */
+	dsa_pointer key;			/* key string, see SharedPlanCacheKey() */
+	dsa_pointer plan;			/* nodeToString() of the PlannedStmt list */
+	dsa_pointer relids;			/* array of OIDs of relations used */
+	int			nrelids;
+	dsa_pointer invalitems;		/* array of SharedPlanInvalItem */
+	int			ninvalitems;
+} SharedPlanCacheEntry;
+
+/* GUC parameter */
+int			shared_plan_cache_size = 0;
+
+static SharedPlanCacheControl *spc_ctl = NULL;
+static HTAB *spc_hash = NULL;
+static dsa_area *spc_area = NULL;
+
+static Size spc_dsa_size(void);
+static long spc_max_entries(void);
+static uint64 spc_hash_key(const char *key);
+static bool spc_store(dsa_pointer *dp, const void *data, Size len);
+static void spc_free_entry(SharedPlanCacheEntry *entry);
+static bool spc_entry_matches(SharedPlanCacheEntry *entry, Oid relid,
+							  int cacheid, uint32 hashvalue);
+static void spc_remove_entries(Oid relid, int cacheid, uint32 hashvalue);
+
+
+/*
+ * Size of the area holding keys and plans
+ */
+static Size
+spc_dsa_size(void)
+{
+	Size		sz;
+
+	sz = mul_size((Size) shared_plan_cache_size, 1024 * 1024);
+	return MAXALIGN(Max(sz, dsa_minimum_size()));
+}
+
+/*
+ * Maximum number of entries in the hashtable
+ */
+static long
+spc_max_entries(void)
+{
+	return Max(spc_dsa_size() / SPC_AVG_ENTRY_SIZE, 16);
+}
+
+/*
+ * Estimate shared memory space needed
+ */
+Size
+SharedPlanCacheShmemSize(void)
+{
+	Size		sz;
+
+	if (shared_plan_cache_size == 0)
+		return 0;
+
+	sz = MAXALIGN(sizeof(SharedPlanCacheControl));
+	sz = add_size(sz, spc_dsa_size());
+	sz = add_size(sz, hash_estimate_size(spc_max_entries(),
+										 sizeof(SharedPlanCacheEntry)));
+
+	return sz;
+}
+
+/*
+ * Allocate and initialize shared memory
+ */
+void
+SharedPlanCacheShmemInit(void)
+{
+	HASHCTL		info;
+	bool		found;
+
+	if (shared_plan_cache_size == 0)
+		return;
+
+	spc_ctl = (SharedPlanCacheControl *)
+		ShmemInitStruct("Shared Plan Cache",
+						add_size(MAXALIGN(sizeof(SharedPlanCacheControl)),
+								 spc_dsa_size()),
+						&found);
+
+	if (!found)
+	{
+		dsa_area   *dsa;
+
+		LWLockInitialize(&spc_ctl->lock, LWTRANCHE_SHARED_PLAN_CACHE);
+
+		/*
+		 * Create the area in plain shared memory, and don't let it grow
+		 * beyond that: postmaster cannot use dsm segments, and the cache is
+		 * meant to have a fixed size anyway.
+		 */
+		spc_ctl->raw_dsa_area = (char *) spc_ctl +
+			MAXALIGN(sizeof(SharedPlanCacheControl));
+		dsa = dsa_create_in_place(spc_ctl->raw_dsa_area, spc_dsa_size(),
+								  LWTRANCHE_SHARED_PLAN_CACHE_DSA, NULL);
+		dsa_pin(dsa);
+		dsa_set_size_limit(dsa, spc_dsa_size());
+		dsa_detach(dsa);
+	}
+
+	info.keysize = sizeof(uint64);
+	info.entrysize = sizeof(SharedPlanCacheEntry);
+	spc_hash = ShmemInitHash("Shared Plan Cache hash",
+							 spc_max_entries(), spc_max_entries(),
+							 &info,
+							 HASH_ELEM | HASH_BLOBS);
+}
+
+/*
+ * SharedPlanCacheAttach: attach to the shared area, during InitPostgres, or
+ * in the startup process when it first replays invalidation messages.
+ *
+ * Does nothing if the shared plan cache is disabled.
+ */
+void
+SharedPlanCacheAttach(void)
+{
+	MemoryContext oldcontext;
+
+	if (spc_ctl == NULL || spc_area != NULL)
+		return;
+
+	/* the mapping persists for the backend lifetime */
+	oldcontext = MemoryContextSwitchTo(TopMemoryContext);
+
+	spc_area = dsa_attach_in_place(spc_ctl->raw_dsa_area, NULL);
+	dsa_pin_mapping(spc_area);
+	on_shmem_exit(dsa_on_shmem_exit_release_in_place,
+				  PointerGetDatum(spc_ctl->raw_dsa_area));
+
+	MemoryContextSwitchTo(oldcontext);
+}
+
+/*
+ * SharedPlanCacheEnabled: can this backend use the shared plan cache?
+ */
+bool
+SharedPlanCacheEnabled(void)
+{
+	return spc_area != NULL;
+}
+
+/*
+ * SharedPlanCacheGeneration: return the current invalidation generation,
+ * that is the number of invalidation messages ever queued.
+ *
+ * The caller must fetch this before absorbing invalidation messages and
+ * building the plan it later passes to SharedPlanCacheInsert.
+ */
+uint64
+SharedPlanCacheGeneration(void)
+{
+	Assert(spc_area != NULL);
+
+	return SIGetTotalMessages();
+}
+
+/*
+ * SharedPlanCacheKey: build the key for a generic plan of query_list.
+ *
+ * Returns NULL if the statement must not be shared.  The caller is
+ * responsible for excluding statements subject to row-level security.
+ */
+char *
+SharedPlanCacheKey(List *query_list, int cursor_options)
+{
+	StringInfoData buf;
+	struct config_generic **gucs;
+	int			num;
+	List	   *search_path;
+	ListCell   *lc;
+
+	foreach(lc, query_list)
+	{
+		Query	   *query = lfirst_node(Query, lc);
+
+		if (query->commandType == CMD_UTILITY)
+			return NULL;
+	}
+
+	initStringInfo(&buf);
+	appendStringInfo(&buf, "%d %u %u", cursor_options,
+					 MyDatabaseId, GetUserId());
+
+	search_path = fetch_search_path(true);
+	appendStringInfoString(&buf, " search_path=");
+	foreach(lc, search_path)
+		appendStringInfo(&buf, "%u,", lfirst_oid(lc));
+	list_free(search_path);
+
+	for (int i = 0; i < lengthof(spc_parser_gucs); i++)
+		appendStringInfo(&buf, " %s=%s", spc_parser_gucs[i],
+						 GetConfigOption(spc_parser_gucs[i], false, false));
+
+	gucs = get_explain_guc_options(&num);
+	for (int i = 0; i < num; i++)
+	{
+		char	   *setting;
+
+		setting = GetConfigOptionByName(gucs[i]->name, NULL, true);
+		appendStringInfo(&buf, " %s=%s", gucs[i]->name,
+						 setting ? setting : "");
+	}
+	pfree(gucs);
+
+	appendStringInfoChar(&buf, ' ');
+	appendStringInfoString(&buf, nodeToString(query_list));
+
+	return buf.data;
+}
+
+/*
+ * SharedPlanCacheLookup: look for a plan published under the given key.
+ *
+ * Returns a freshly read copy of the PlannedStmt list, or NIL if there is
+ * none.
+ */
+List *
+SharedPlanCacheLookup(const char *key)
+{
+	uint64		hashkey = spc_hash_key(key);
+	SharedPlanCacheEntry *entry;
+	char	   *plan = NULL;
+	List	   *stmt_list;
+
+	Assert(spc_area != NULL);
+
+	LWLockAcquire(&spc_ctl->lock, LW_SHARED);
+
+	entry = (SharedPlanCacheEntry *) hash_search(spc_hash, &hashkey,
+												 HASH_FIND, NULL);
+	if (entry != NULL &&
+		strcmp(dsa_get_address(spc_area, entry->key), key) == 0)
+		plan = pstrdup(dsa_get_address(spc_area, entry->plan));
+
+	LWLockRelease(&spc_ctl->lock);
+
+	if (plan == NULL)
+		return NIL;
+
+	stmt_list = (List *) stringToNode(plan);
+	pfree(plan);
+
+	return stmt_list;
+}
+
+/*
+ * SharedPlanCacheInsert: publish a generic plan under the given key.
+ *
+ * generation is the value SharedPlanCacheGeneration() returned before the
+ * plan was built.  Nothing happens if the plan is not shareable, if an
+ * invalidation has been processed since, if another backend has published
+ * a plan already, or if there is no room.
+ */
+void
+SharedPlanCacheInsert(const char *key, List *stmt_list, uint64 generation)
+{
+	uint64		hashkey = spc_hash_key(key);
+	List	   *relids = NIL;
+	List	   *invalitems = NIL;
+	Oid		   *relid_array;
+	SharedPlanInvalItem *item_array;
+	char	   *plan;
+	SharedPlanCacheEntry *entry;
+	bool		found;
+	int			i;
+	ListCell   *lc;
+
+	Assert(spc_area != NULL);
+
+	foreach(lc, stmt_list)
+	{
+		PlannedStmt *plannedstmt = lfirst_node(PlannedStmt, lc);
+
+		if (plannedstmt->commandType == CMD_UTILITY ||
+			plannedstmt->transientPlan ||
+			plannedstmt->dependsOnRole)
+			return;
+
+		relids = list_concat(relids, plannedstmt->relationOids);
+		invalitems = list_concat(invalitems, plannedstmt->invalItems);
+	}
+
+	/* Flatten everything before taking the lock */
+	plan = nodeToString(stmt_list);
+
+	relid_array = palloc(Max(list_length(relids), 1) * sizeof(Oid));
+	i = 0;
+	foreach(lc, relids)
+		relid_array[i++] = lfirst_oid(lc);
+
+	item_array = palloc(Max(list_length(invalitems), 1) *
+						sizeof(SharedPlanInvalItem));
+	i = 0;
+	foreach(lc, invalitems)
+	{
+		PlanInvalItem *item = lfirst_node(PlanInvalItem, lc);
+
+		item_array[i].cacheId = item->cacheId;
+		item_array[i].hashValue = item->hashValue;
+		i++;
+	}
+
+	LWLockAcquire(&spc_ctl->lock, LW_EXCLUSIVE);
+
+	/*
+	 * Don't publish a plan that an invalidation may have made outdated.  We
+	 * must check under the lock, so that whoever processes any message
+	 * queued after the check finds the new entry.
+	 */
+	if (SIGetTotalMessages() != generation ||
+		hash_get_num_entries(spc_hash) >= spc_max_entries())
+	{
+		LWLockRelease(&spc_ctl->lock);
+		return;
+	}
+
+	entry = (SharedPlanCacheEntry *) hash_search(spc_hash, &hashkey,
+												 HASH_ENTER_NULL, &found);
+	if (entry == NULL || found)
+	{
+		LWLockRelease(&spc_ctl->lock);
+		return;
+	}
+
+	entry->key = InvalidDsaPointer;
+	entry->plan = InvalidDsaPointer;
+	entry->relids = InvalidDsaPointer;
+	entry->nrelids = list_length(relids);
+	entry->invalitems = InvalidDsaPointer;
+	entry->ninvalitems = list_length(invalitems);
+
+	if (!spc_store(&entry->key, key, strlen(key) + 1) ||
+		!spc_store(&entry->plan, plan, strlen(plan) + 1) ||
+		!spc_store(&entry->relids, relid_array,
+				   entry->nrelids * sizeof(Oid)) ||
+		!spc_store(&entry->invalitems, item_array,
+				   entry->ninvalitems * sizeof(SharedPlanInvalItem)))
+	{
+		/* out of space; forget it */
+		spc_free_entry(entry);
+		hash_search(spc_hash, &hashkey, HASH_REMOVE, NULL);
+	}
+
+	LWLockRelease(&spc_ctl->lock);
+}
+
+/*
+ * SharedPlanCacheInvalidateRelation: remove plans mentioning the given rel,
+ * or all plans if relid == InvalidOid.
+ */
+void
+SharedPlanCacheInvalidateRelation(Oid relid)
+{
+	spc_remove_entries(relid, -1, 0);
+}
+
+/*
+ * SharedPlanCacheInvalidateObject: remove plans mentioning the object with
+ * the specified hash value, or any member of this cache if hashvalue == 0.
+ */
+void
+SharedPlanCacheInvalidateObject(int cacheid, uint32 hashvalue)
+{
+	spc_remove_entries(InvalidOid, cacheid, hashvalue);
+}
+
+/*
+ * SharedPlanCacheReset: remove all plans.
+ */
+void
+SharedPlanCacheReset(void)
+{
+	spc_remove_entries(InvalidOid, -1, 0);
+}
+
+/*
+ * SharedPlanCacheProcessMessages: remove the plans affected by invalidation
+ * messages that the current process has just queued, at commit or while
+ * replaying one.
+ *
+ * This does for the shared cache what plancache.c's invalidation callbacks
+ * do for a backend's own plans, so the syscaches handled here must match the
+ * ones InitPlanCache registers callbacks for.
+ */
+void
+SharedPlanCacheProcessMessages(const SharedInvalidationMessage *msgs, int n)
+{
+	if (AmStartupProcess())
+		SharedPlanCacheAttach();
+	if (spc_area == NULL)
+		return;
+
+	for (int i = 0; i < n; i++)
+	{
+		const SharedInvalidationMessage *msg = &msgs[i];
+
+		if (msg->id >= 0)
+		{
+			switch (msg->cc.id)
+			{
+				case PROCOID:
+				case TYPEOID:
+					SharedPlanCacheInvalidateObject(msg->cc.id,
+													msg->cc.hashValue);
+					break;
+				case NAMESPACEOID:
+				case OPEROID:
+				case AMOPOPID:
+				case FOREIGNSERVEROID:
+				case FOREIGNDATAWRAPPEROID:
+					SharedPlanCacheReset();
+					break;
+				default:
+					break;
+			}
+		}
+		else if (msg->id == SHAREDINVALCATALOG_ID)
+			SharedPlanCacheReset();
+		else if (msg->id == SHAREDINVALRELCACHE_ID)
+			SharedPlanCacheInvalidateRelation(msg->rc.relId);
+	}
+}
+
+static uint64
+spc_hash_key(const char *key)
+{
+	return hash_bytes_extended((const unsigned char *) key, strlen(key), 0);
+}
+
+/*
+ * Copy len bytes of data into the shared area, setting *dp to point to the
+ * copy.  Returns false if there is no room.  An empty array is represented
+ * by InvalidDsaPointer.
+ */
+static bool
+spc_store(dsa_pointer *dp, const void *data, Size len)
+{
+	if (len == 0)
+	{
+		*dp = InvalidDsaPointer;
+		return true;
+	}
+
+	*dp = dsa_allocate_extended(spc_area, len, DSA_ALLOC_NO_OOM);
+	if (!DsaPointerIsValid(*dp))
+		return false;
+
+	memcpy(dsa_get_address(spc_area, *dp), data, len);
+	return true;
+}
+
+/* Release the shared memory used by an entry */
+static void
+spc_free_entry(SharedPlanCacheEntry *entry)
+{
+	if (DsaPointerIsValid(entry->key))
+		dsa_free(spc_area, entry->key);
+	if (DsaPointerIsValid(entry->plan))
+		dsa_free(spc_area, entry->plan);
+	if (DsaPointerIsValid(entry->relids))
+		dsa_free(spc_area, entry->relids);
+	if (DsaPointerIsValid(entry->invalitems))
+		dsa_free(spc_area, entry->invalitems);
+}
+
+/*
+ * Does the entry depend on the given relation (if relid is valid), or on the
+ * given syscache entry (if cacheid >= 0; hashvalue 0 meaning any entry)?
+ * With neither, every entry matches.
+ */
+static bool
+spc_entry_matches(SharedPlanCacheEntry *entry, Oid relid,
+				  int cacheid, uint32 hashvalue)
+{
+	if (OidIsValid(relid))
+	{
+		Oid		   *relids = dsa_get_address(spc_area, entry->relids);
+
+		for (int i = 0; i < entry->nrelids; i++)
+		{
+			if (relids[i] == relid)
+				return true;
+		}
+		return false;
+	}
+
+	if (cacheid >= 0)
+	{
+		SharedPlanInvalItem *items = dsa_get_address(spc_area,
+													 entry->invalitems);
+
+		for (int i = 0; i < entry->ninvalitems; i++)
+		{
+			if (items[i].cacheId == cacheid &&
+				(hashvalue == 0 || items[i].hashValue == hashvalue))
+				return true;
+		}
+		return false;
+	}
+
+	return true;
+}
+
+/*
+ * Remove the entries matching the given dependency; see spc_entry_matches.
+ *
+ * This is called from invalidation callbacks, so it must not fail.
+ */
+static void
+spc_remove_entries(Oid relid, int cacheid, uint32 hashvalue)
+{
+	HASH_SEQ_STATUS hash_seq;
+	SharedPlanCacheEntry *entry;
+	bool		found = false;
+
+	if (spc_area == NULL)
+		return;
+
+	/*
+	 * Every backend processes every invalidation, and most of them concern
+	 * no published plan, so check under a shared lock first.
+	 */
+	LWLockAcquire(&spc_ctl->lock, LW_SHARED);
+
+	hash_seq_init(&hash_seq, spc_hash);
+	while ((entry = hash_seq_search(&hash_seq)) != NULL)
+	{
+		if (spc_entry_matches(entry, relid, cacheid, hashvalue))
+		{
+			found = true;
+			hash_seq_term(&hash_seq);
+			break;
+		}
+	}
+
+	LWLockRelease(&spc_ctl->lock);
+
+	if (!found)
+		return;
+
+	LWLockAcquire(&spc_ctl->lock, LW_EXCLUSIVE);
+
+	hash_seq_init(&hash_seq, spc_hash);
+	while ((entry = hash_seq_search(&hash_seq)) != NULL)
+	{
+		if (spc_entry_matches(entry, relid, cacheid, hashvalue))
+		{
+			spc_free_entry(entry);
+			hash_search(spc_hash, &entry->hashkey, HASH_REMOVE, NULL);
+		}
+	}
+
+	LWLockRelease(&spc_ctl->lock);
+}
@@ -137,6 +137,8 @@ extern bool heap_fetch(Relation relation, Snapshot snapshot,
 extern bool heap_hot_search_buffer(ItemPointer tid, Relation relation,
 								   Buffer buffer, Snapshot snapshot, HeapTuple heapTuple,
 								   bool *all_dead, bool first_call);
+extern bool heap_page_visible_to_snapshot(Relation relation, Buffer buffer,
+										  Snapshot snapshot, OffsetNumber *maxoff);
 
 extern void heap_get_latest_tid(TableScanDesc scan, ItemPointer tid);
 
@@ -184,6 +186,7 @@ extern TransactionId heap_index_delete_tuples(Relation rel,
 /* in heap/pruneheap.c */
 struct GlobalVisState;
 extern void heap_page_prune_opt(Relation relation, Buffer buffer);
+extern void heap_page_prune_deferred(Oid relid, BlockNumber blkno);
 extern int	heap_page_prune(Relation relation, Buffer buffer,
 							struct GlobalVisState *vistest,
 							TransactionId old_snap_xmin,
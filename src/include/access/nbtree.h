@@ -1066,6 +1066,19 @@ typedef struct BTScanOpaqueData
 	 */
 	int			markItemIndex;	/* itemIndex, or -1 if not valid */
 
+	/*
+	 * Forward scans with an equality key on the second index column, but no
+	 * key on the leading column, can skip over the parts of each leading
+	 * column group that cannot contain matches by descending the tree again
+	 * rather than stepping right (see _bt_skip_prepare()).  skipPending is
+	 * set by _bt_readpage() when the high key saved in skipTuple shows that
+	 * the right sibling page is not worth reading.
+	 */
+	ScanKey		skipKey;		/* second column's equality key, or NULL */
+	bool		skipPending;	/* descend rather than step right? */
+	bool		skipNextGroup;	/* skip past skipTuple's leading value? */
+	IndexTuple	skipTuple;		/* workspace of size BLCKSZ, or NULL */
+
 	/* keep these last in struct for efficiency */
 	BTScanPosData currPos;		/* current position data */
 	BTScanPosData markPos;		/* marked position, if any */
@@ -1245,6 +1258,7 @@ extern bool _bt_advance_array_keys(IndexScanDesc scan, ScanDirection dir);
 extern void _bt_mark_array_keys(IndexScanDesc scan);
 extern void _bt_restore_array_keys(IndexScanDesc scan);
 extern void _bt_preprocess_keys(IndexScanDesc scan);
+extern void _bt_skip_prepare(IndexScanDesc scan);
 extern bool _bt_checkkeys(IndexScanDesc scan, IndexTuple tuple,
 						  int tupnatts, ScanDirection dir, bool *continuescan);
 extern void _bt_killitems(IndexScanDesc scan);
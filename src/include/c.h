@@ -1143,9 +1143,28 @@ typedef union PGAlignedBlock
 	int64		force_align_i64;
 } PGAlignedBlock;
 
-/* Same, but for an XLOG_BLCKSZ-sized buffer */
+/*
+ * Use this to declare a field or local variable holding a page buffer that
+ * is passed directly to smgr routines, so that it can be used for direct I/O
+ * without a copy (see debug_io_direct).  The extra alignment is not needed
+ * otherwise, and would waste stack space.
+ */
+typedef union PGIOAlignedBlock
+{
+#ifdef pg_attribute_aligned
+	pg_attribute_aligned(PG_IO_ALIGN_SIZE)
+#endif
+	char		data[BLCKSZ];
+	double		force_align_d;
+	int64		force_align_i64;
+} PGIOAlignedBlock;
+
+/* Same, but for an XLOG_BLCKSZ-sized buffer, which WAL files may need */
 typedef union PGAlignedXLogBlock
 {
+#ifdef pg_attribute_aligned
+	pg_attribute_aligned(PG_IO_ALIGN_SIZE)
+#endif
 	char		data[XLOG_BLCKSZ];
 	double		force_align_d;
 	int64		force_align_i64;
@@ -53,6 +53,15 @@ typedef struct WalUsage
 	uint64		wal_bytes;		/* size of WAL records produced */
 } WalUsage;
 
+/*
+ * With INSTRUMENT_TIMER_SAMPLED (which has no effect without INSTRUMENT_TIMER)
+ * only the first two calls of each cycle and every
+ * INSTR_TIMER_SAMPLE_PERIOD'th call after them read the clock.  The first
+ * call's time is kept exact, and the time of the other calls is extrapolated
+ * from the timed ones.  Row counts remain exact.
+ */
+#define INSTR_TIMER_SAMPLE_PERIOD	64
+
 /* Flag bits included in InstrAlloc's instrument_options bitmask */
 typedef enum InstrumentOption
 {
@@ -60,7 +69,10 @@ typedef enum InstrumentOption
 	INSTRUMENT_BUFFERS = 1 << 1,	/* needs buffer usage */
 	INSTRUMENT_ROWS = 1 << 2,	/* needs row count */
 	INSTRUMENT_WAL = 1 << 3,	/* needs WAL usage */
-	INSTRUMENT_ALL = PG_INT32_MAX
+	INSTRUMENT_TIMER_SAMPLED = 1 << 4,	/* time only a sample of node calls */
+	/* everything exact; INSTRUMENT_TIMER_SAMPLED must be asked for */
+	INSTRUMENT_ALL = INSTRUMENT_TIMER | INSTRUMENT_BUFFERS | INSTRUMENT_ROWS |
+	INSTRUMENT_WAL
 } InstrumentOption;
 
 typedef struct Instrumentation
@@ -70,10 +82,14 @@ typedef struct Instrumentation
 	bool		need_bufusage;	/* true if we need buffer usage data */
 	bool		need_walusage;	/* true if we need WAL usage data */
 	bool		async_mode;		/* true if node is in async mode */
+	bool		sample_timer;	/* true if timing only sampled calls */
 	/* Info about current plan cycle: */
 	bool		running;		/* true if we've completed first tuple */
 	instr_time	starttime;		/* start time of current iteration of node */
 	instr_time	counter;		/* accumulated runtime for this node */
+	uint64		ncalls;			/* # of calls so far this cycle */
+	uint64		ntimed;			/* # of those calls that were timed */
+	double		firstcall;		/* time of first call of this cycle */
 	double		firsttuple;		/* time for first tuple of this cycle */
 	double		tuplecount;		/* # of tuples emitted so far this cycle */
 	BufferUsage bufusage_start; /* buffer usage at start */
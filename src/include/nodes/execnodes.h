@@ -1548,6 +1548,11 @@ typedef struct IndexScanState
  *		ScanDesc		   index scan descriptor
  *		TableSlot		   slot for holding tuples fetched from the table
  *		VMBuffer		   buffer in use for visibility map testing, if any
+ *		CheckHeapPages	   may we check heap pages for visibility as a whole?
+ *		LastHeapBlock	   heap block we visited most recently
+ *		CheckedBlock	   heap block most recently checked as a whole
+ *		VisibleBlock	   heap block known to be visible to our snapshot
+ *		VisibleMaxOffset   ... up to this offset number
  *		PscanLen		   size of parallel index-only scan descriptor
  * ----------------
  */
@@ -1567,6 +1572,11 @@ typedef struct IndexOnlyScanState
 	struct IndexScanDescData *ioss_ScanDesc;
 	TupleTableSlot *ioss_TableSlot;
 	Buffer		ioss_VMBuffer;
+	bool		ioss_CheckHeapPages;
+	BlockNumber ioss_LastHeapBlock;
+	BlockNumber ioss_CheckedBlock;
+	BlockNumber ioss_VisibleBlock;
+	OffsetNumber ioss_VisibleMaxOffset;
 	Size		ioss_PscanLen;
 } IndexOnlyScanState;
 
@@ -1960,6 +1970,13 @@ typedef struct JoinState
  *		NeedNewOuter	   true if need new outer tuple on next call
  *		MatchedOuter	   true if found a join match for current outer tuple
  *		NullInnerTupleSlot prepared null tuple for left outer joins
+ *		AdaptiveMaterial   true if inner may be materialized at runtime
+ *		OuterTuples		   # of outer tuples fetched since last rescan
+ *		InnerTuples		   materialized inner tuples, or NULL
+ *		InnerComplete	   true if InnerTuples holds the whole inner rel
+ *		InnerMaterialized  true if inner has ever been materialized
+ *		InnerStoreSlot	   slot for reading InnerTuples
+ *		InnerTupleSlot	   slot of the inner plan's kind to return them in
  * ----------------
  */
 typedef struct NestLoopState
@@ -1968,6 +1985,13 @@ typedef struct NestLoopState
 	bool		nl_NeedNewOuter;
 	bool		nl_MatchedOuter;
 	TupleTableSlot *nl_NullInnerTupleSlot;
+	bool		nl_AdaptiveMaterial;
+	double		nl_OuterTuples;
+	Tuplestorestate *nl_InnerTuples;
+	bool		nl_InnerComplete;
+	bool		nl_InnerMaterialized;
+	TupleTableSlot *nl_InnerStoreSlot;
+	TupleTableSlot *nl_InnerTupleSlot;
 } NestLoopState;
 
 /* ----------------
@@ -675,6 +675,7 @@ extern uintptr_t readDatum(bool typbyval);
 extern bool *readBoolCols(int numCols);
 extern int *readIntCols(int numCols);
 extern Oid *readOidCols(int numCols);
+extern Index *readIndexCols(int numCols);
 extern int16 *readAttrNumberCols(int numCols);
 
 /*
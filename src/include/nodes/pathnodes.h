@@ -107,6 +107,10 @@ typedef struct PlannerGlobal
 
 	List	   *appendRelations;	/* "flat" list of AppendRelInfos */
 
+	List	   *partPruneInfos; /* "flat" list of PartitionPruneInfos */
+
+	Bitmapset  *prunableRelids; /* leaf partitions covered by the above */
+
 	List	   *relationOids;	/* OIDs of relations the plan depends on */
 
 	List	   *invalItems;		/* other dependencies, as PlanInvalItems */
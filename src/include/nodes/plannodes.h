@@ -78,6 +78,15 @@ typedef struct PlannedStmt
 
 	List	   *rowMarks;		/* a list of PlanRowMark's */
 
+	/*
+	 * PartitionPruneInfos whose initial pruning steps can be evaluated before
+	 * any of the partitions are locked, and the RT indexes of the leaf
+	 * partitions they cover; see AcquireExecutorLocks().
+	 */
+	List	   *partPruneInfos; /* list of PartitionPruneInfo */
+
+	Bitmapset  *prunableRelids; /* RT indexes of leaf partitions */
+
 	List	   *relationOids;	/* OIDs of relations the plan depends on */
 
 	List	   *invalItems;		/* other dependencies, as PlanInvalItems */
@@ -1218,6 +1227,8 @@ typedef struct PartitionPruneInfo
  * indexes, as stored in 'subplan_map', are global across the parent plan
  * node, but partition indexes are valid only within a particular hierarchy.
  * relid_map[p] contains the partition's OID, or 0 if the partition was pruned.
+ * leafpart_rti_map[p] contains the RT index of leaf partition p, or 0 if the
+ * partition is non-leaf or has been pruned.
  */
 typedef struct PartitionedRelPruneInfo
 {
@@ -1229,6 +1240,7 @@ typedef struct PartitionedRelPruneInfo
 	int		   *subplan_map;	/* subplan index by partition index, or -1 */
 	int		   *subpart_map;	/* subpart index by partition index, or -1 */
 	Oid		   *relid_map;		/* relation OID by partition index, or 0 */
+	Index	   *leafpart_rti_map;	/* leaf RT index by partition index, or 0 */
 
 	/*
 	 * initial_pruning_steps shows how to prune during executor startup (i.e.,
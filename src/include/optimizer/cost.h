@@ -41,6 +41,35 @@ typedef enum
 }			ConstraintExclusionType;
 
 
+/*
+ * Hooks for plugins to adjust row count estimates, for instance using the
+ * actual row counts observed in earlier executions of similar queries.  They
+ * are passed the standard estimate and return the one to use.
+ *
+ * The base relation hook is called with param_clauses = NIL for the
+ * relation's unparameterized size, and with the extra join clauses for a
+ * parameterized scan; the relation's own restriction clauses are in
+ * rel->baserestrictinfo.  The join relation hook is called for both
+ * unparameterized and parameterized joins, with the sizes assumed for the
+ * input relations.
+ */
+typedef double (*baserel_rows_estimate_hook_type) (PlannerInfo *root,
+												   RelOptInfo *rel,
+												   List *param_clauses,
+												   double nrows);
+extern PGDLLIMPORT baserel_rows_estimate_hook_type baserel_rows_estimate_hook;
+
+typedef double (*joinrel_rows_estimate_hook_type) (PlannerInfo *root,
+												   RelOptInfo *joinrel,
+												   RelOptInfo *outer_rel,
+												   RelOptInfo *inner_rel,
+												   double outer_rows,
+												   double inner_rows,
+												   SpecialJoinInfo *sjinfo,
+												   List *restrictlist,
+												   double nrows);
+extern PGDLLIMPORT joinrel_rows_estimate_hook_type joinrel_rows_estimate_hook;
+
 /*
  * prototypes for costsize.c
  *	  routines to compute costs and sizes
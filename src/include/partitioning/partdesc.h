@@ -36,6 +36,17 @@ typedef struct PartitionDescData
 								 * the corresponding 'oids' element belongs to
 								 * a leaf partition or not */
 	PartitionBoundInfo boundinfo;	/* collection of partition bounds */
+
+	/*
+	 * Tuple routing cache, maintained by get_partition_for_tuple().
+	 * last_found_part_index is the partition index that the most recent
+	 * tuples were routed to, last_found_datum_index the offset of its bound
+	 * in boundinfo->datums, and last_found_count how many consecutive tuples
+	 * went there.  Not used for hash partitioning.
+	 */
+	int			last_found_datum_index;
+	int			last_found_part_index;
+	int			last_found_count;
 } PartitionDescData;
 
 
@@ -22,7 +22,9 @@
  */
 typedef enum
 {
-	AVW_BRINSummarizeRange
+	AVW_BRINSummarizeRange,
+	AVW_HeapPrunePage,
+	AVW_GinCleanPendingList
 } AutoVacuumWorkItemType;
 
 
@@ -300,6 +300,27 @@ typedef struct CkptSortItem
 
 extern PGDLLIMPORT CkptSortItem *CkptBufferIds;
 
+/*
+ * The dirty buffer map has one bit per shared buffer, which is set whenever
+ * the buffer goes from clean to dirty.  The bits of buffers that were
+ * cleaned are only reset lazily, by BufferSync(), so the map is a superset
+ * of the dirty buffers.  It lets checkpoints find the dirty buffers without
+ * examining every buffer header, which matters for large, mostly clean
+ * buffer pools.
+ */
+#define BUFFERS_PER_DIRTY_MAP_WORD	32
+#define DirtyMapWords() \
+	((NBuffers + BUFFERS_PER_DIRTY_MAP_WORD - 1) / BUFFERS_PER_DIRTY_MAP_WORD)
+
+extern PGDLLIMPORT pg_atomic_uint32 *BufferDirtyMap;
+
+static inline void
+BufferDirtyMapSet(int buf_id)
+{
+	pg_atomic_fetch_or_u32(&BufferDirtyMap[buf_id / BUFFERS_PER_DIRTY_MAP_WORD],
+						   ((uint32) 1) << (buf_id % BUFFERS_PER_DIRTY_MAP_WORD));
+}
+
 /*
  * Internal buffer management routines
  */
@@ -0,0 +1,41 @@
+/*-------------------------------------------------------------------------
+ *
+ * sharedplancache.h
+ *	  Cross-backend cache of generic plans.
+ *
+ * See sharedplancache.c for comments.
+ *
+ * Portions Copyright (c) 1996-2022, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/utils/sharedplancache.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef SHAREDPLANCACHE_H
+#define SHAREDPLANCACHE_H
+
+#include "nodes/pg_list.h"
+#include "storage/sinval.h"
+
+/* GUC parameter */
+extern PGDLLIMPORT int shared_plan_cache_size;
+
+extern Size SharedPlanCacheShmemSize(void);
+extern void SharedPlanCacheShmemInit(void);
+extern void SharedPlanCacheAttach(void);
+extern bool SharedPlanCacheEnabled(void);
+
+extern uint64 SharedPlanCacheGeneration(void);
+extern char *SharedPlanCacheKey(List *query_list, int cursor_options);
+extern List *SharedPlanCacheLookup(const char *key);
+extern void SharedPlanCacheInsert(const char *key, List *stmt_list,
+								  uint64 generation);
+
+extern void SharedPlanCacheInvalidateRelation(Oid relid);
+extern void SharedPlanCacheInvalidateObject(int cacheid, uint32 hashvalue);
+extern void SharedPlanCacheReset(void);
+extern void SharedPlanCacheProcessMessages(const SharedInvalidationMessage *msgs,
+										   int n);
+
+#endif							/* SHAREDPLANCACHE_H */
@@ -0,0 +1,41 @@
+# index-only scan page visibility test
+#
+# An index-only scan that finds every tuple on a heap page visible to its
+# snapshot skips the heap fetches for the rest of that page, even though the
+# page isn't marked all-visible.  Check that rows concurrently inserted into
+# and deleted from such a page are still seen according to the snapshot.
+
+setup
+{
+  CREATE TABLE ios_page (a int) WITH (autovacuum_enabled = off);
+  INSERT INTO ios_page SELECT g * 10 FROM generate_series(1, 100) g;
+  CREATE INDEX ios_page_a ON ios_page (a);
+}
+
+teardown
+{
+  DROP TABLE ios_page;
+}
+
+session s1
+setup
+{
+  SET enable_seqscan = off;
+  SET enable_bitmapscan = off;
+}
+step s1_begin { BEGIN ISOLATION LEVEL REPEATABLE READ; }
+step s1_explain { EXPLAIN (COSTS OFF) SELECT a FROM ios_page WHERE a BETWEEN 10 AND 100 ORDER BY a; }
+step s1_declare { DECLARE c CURSOR FOR SELECT a FROM ios_page WHERE a BETWEEN 10 AND 100 ORDER BY a; }
+step s1_fetch { FETCH 3 FROM c; }
+step s1_fetch_all { FETCH ALL FROM c; }
+step s1_select { SELECT a FROM ios_page WHERE a BETWEEN 10 AND 100 ORDER BY a; }
+step s1_commit { COMMIT; }
+
+session s2
+step s2_change { INSERT INTO ios_page VALUES (55); DELETE FROM ios_page WHERE a = 70; }
+
+# The page is checked by the first FETCH, before the concurrent changes
+permutation s1_explain s1_begin s1_declare s1_fetch s2_change s1_fetch_all s1_commit s1_select
+
+# The page is checked after the concurrent changes, with an older snapshot
+permutation s1_begin s1_select s2_change s1_select s1_commit s1_select
@@ -29,9 +29,33 @@ my $count = $node->safe_psql('postgres',
 );
 is($count, '1', "initial index state is correct");
 
+# Hold a lock that keeps the inserts from summarizing the ranges they start
+# themselves, so that they are left to autovacuum's work items
+my $in    = '';
+my $out   = '';
+my $timer = IPC::Run::timeout($PostgreSQL::Test::Utils::timeout_default);
+my $h     = $node->background_psql('postgres', \$in, \$out, $timer,
+	on_error_stop => 1);
+$in .= q(
+begin;
+lock table brin_wi in share update exclusive mode;
+\echo locked
+);
+pump $h until $out =~ /locked/ || $timer->is_expired;
+
 $node->safe_psql('postgres',
 	'insert into brin_wi select * from generate_series(1, 100)');
 
+$count = $node->safe_psql('postgres',
+	"select count(*) from brin_page_items(get_raw_page('brin_wi_idx', 2), 'brin_wi_idx'::regclass)"
+);
+is($count, '1', "ranges not summarized by the inserts");
+
+$in .= q(
+commit;
+);
+$h->finish;
+
 $node->poll_query_until(
 	'postgres',
 	"select count(*) > 1 from brin_page_items(get_raw_page('brin_wi_idx', 2), 'brin_wi_idx'::regclass)",
@@ -0,0 +1,49 @@
+
+# Copyright (c) 2021-2022, PostgreSQL Global Development Group
+
+# Verify that inserts summarize the page ranges they start at the end of the
+# table
+
+use strict;
+use warnings;
+
+use PostgreSQL::Test::Utils;
+use Test::More;
+use PostgreSQL::Test::Cluster;
+
+my $node = PostgreSQL::Test::Cluster->new('main');
+$node->init;
+
+# Make sure no work item does the summarization instead
+$node->append_conf('postgresql.conf', 'autovacuum = off');
+$node->start;
+
+$node->safe_psql('postgres', 'create extension pageinspect');
+
+$node->safe_psql(
+	'postgres',
+	'create table brin_ins (a int) with (fillfactor = 10);
+	 create index brin_ins_idx on brin_ins using brin (a) with (pages_per_range=1, autosummarize=on);
+	 '
+);
+
+$node->safe_psql('postgres',
+	'insert into brin_ins select * from generate_series(1, 100)');
+
+# Every range is summarized, including the one the last insert started
+my $result = $node->safe_psql('postgres',
+	"select count(*) = pg_relation_size('brin_ins') / current_setting('block_size')::int
+	 from brin_page_items(get_raw_page('brin_ins_idx', 2), 'brin_ins_idx'::regclass)"
+);
+is($result, 't', "all ranges summarized by the inserts");
+
+# The summary of the last range covers the last row
+$result = $node->safe_psql('postgres',
+	"select value from brin_page_items(get_raw_page('brin_ins_idx', 2), 'brin_ins_idx'::regclass)
+	 order by blknum desc limit 1"
+);
+like($result, qr/ \.\. 100\}$/, "last range summary includes the last row");
+
+$node->stop;
+
+done_testing();
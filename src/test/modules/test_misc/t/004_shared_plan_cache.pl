@@ -0,0 +1,103 @@
+
+# Copyright (c) 2021-2022, PostgreSQL Global Development Group
+
+# Check that plans shared through shared_plan_cache_size are only used by
+# sessions they are valid for
+
+use strict;
+use warnings;
+use PostgreSQL::Test::Cluster;
+use PostgreSQL::Test::Utils;
+use Test::More;
+
+my $node = PostgreSQL::Test::Cluster->new('main');
+$node->init;
+$node->append_conf(
+	'postgresql.conf', qq(
+shared_plan_cache_size = 1MB
+log_planner_stats = on
+));
+$node->start;
+
+# f() is inlined by the planner, and its body refers to "t" by an
+# unqualified name, so the plan depends on search_path.
+$node->safe_psql(
+	'postgres', q(
+SET check_function_bodies = off;
+CREATE SCHEMA s1;
+CREATE SCHEMA s2;
+CREATE TABLE s1.t (x int);
+CREATE TABLE s2.t (x int);
+INSERT INTO s1.t VALUES (1);
+INSERT INTO s2.t VALUES (2);
+CREATE FUNCTION public.f() RETURNS SETOF int LANGUAGE sql STABLE
+  AS 'SELECT x FROM t';
+));
+
+# Run the prepared statement in a new session with the given search_path.
+# Returns its result, and whether the session planned the statement itself
+# rather than using a plan published by another session.
+sub run_prepared
+{
+	my $search_path = shift;
+	my $log_offset  = -s $node->logfile;
+
+	my $result = $node->safe_psql(
+		'postgres', qq(
+SET search_path = $search_path, public;
+PREPARE q AS SELECT * FROM f();
+EXECUTE q;
+));
+	my $planned =
+	  slurp_file($node->logfile, $log_offset) =~ /PLANNER STATISTICS/;
+
+	return ($result, $planned ? 1 : 0);
+}
+
+is_deeply([ run_prepared('s1') ],
+	[ '1', 1 ], 'plan built with s1 in search_path');
+is_deeply([ run_prepared('s2') ],
+	[ '2', 1 ], 'plan for s1 not used with s2 in search_path');
+is_deeply([ run_prepared('s1') ],
+	[ '1', 0 ], 'plan for s1 used by another session with s1 in search_path');
+
+# A transaction that changes f() must neither publish a plan built from its
+# own uncommitted catalog state, nor use a plan built from the committed one.
+my $in    = '';
+my $out   = '';
+my $timer = IPC::Run::timeout($PostgreSQL::Test::Utils::timeout_default);
+my $h     = $node->background_psql('postgres', \$in, \$out, $timer,
+	on_error_stop => 1);
+
+$in .= q(
+BEGIN;
+CREATE OR REPLACE FUNCTION public.f() RETURNS SETOF int LANGUAGE sql STABLE
+  AS 'SELECT x + 10 FROM t';
+SET search_path = s1, public;
+PREPARE q AS SELECT * FROM f();
+EXECUTE q;
+\echo syncpoint1
+);
+pump $h until $out =~ /syncpoint1/ || $timer->is_expired;
+like($out, qr/^11$/m, 'uncommitted function body used by its transaction');
+
+is((run_prepared('s1'))[0],
+	'1', 'uncommitted function body not used by other sessions');
+
+# Once the change commits, the plan published meanwhile by the other session
+# must go away.
+$in .= q(
+COMMIT;
+\echo syncpoint2
+);
+pump $h until $out =~ /syncpoint2/ || $timer->is_expired;
+$h->finish;
+
+is_deeply([ run_prepared('s1') ],
+	[ '11', 1 ], 'committed function body used by new sessions');
+is_deeply([ run_prepared('s1') ],
+	[ '11', 0 ], 'plan with committed function body used by another session');
+
+$node->stop;
+
+done_testing();
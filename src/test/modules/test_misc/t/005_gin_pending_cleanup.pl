@@ -0,0 +1,52 @@
+
+# Copyright (c) 2021-2022, PostgreSQL Global Development Group
+
+# Check that autovacuum cleans up a GIN index's pending list once it has
+# grown past gin_pending_list_limit, rather than the inserting backend
+
+use strict;
+use warnings;
+use PostgreSQL::Test::Cluster;
+use PostgreSQL::Test::Utils;
+use Test::More;
+
+my $node = PostgreSQL::Test::Cluster->new('main');
+$node->init;
+
+# Keep autovacuum from getting to the index until we have looked at it
+$node->append_conf('postgresql.conf', 'autovacuum_naptime = 1h');
+$node->start;
+
+$node->safe_psql(
+	'postgres', q(
+CREATE EXTENSION pageinspect;
+CREATE TABLE gin_pl (a int[]);
+CREATE INDEX gin_pl_idx ON gin_pl USING gin (a)
+  WITH (fastupdate = on, gin_pending_list_limit = 64);
+));
+
+# About 13 pending list pages: past the 64kB limit, but short of the twice
+# as long list that the inserter would clean up itself.
+$node->safe_psql('postgres',
+	'INSERT INTO gin_pl SELECT array[g] FROM generate_series(1, 5000) g');
+
+my $pending_pages =
+  q{(SELECT n_pending_pages FROM gin_metapage_info(get_raw_page('gin_pl_idx', 0)))};
+
+cmp_ok($node->safe_psql('postgres', "SELECT $pending_pages"),
+	'>', 8, 'pending list left for autovacuum');
+
+$node->safe_psql('postgres', 'ALTER SYSTEM SET autovacuum_naptime = 1');
+$node->reload;
+
+ok($node->poll_query_until('postgres', "SELECT $pending_pages = 0"),
+	'pending list cleaned up by autovacuum');
+
+is( $node->safe_psql(
+		'postgres', 'SELECT count(*) FROM gin_pl WHERE a @> array[4321]'),
+	'1',
+	'cleaned up entries found in the index');
+
+$node->stop;
+
+done_testing();
@@ -0,0 +1,69 @@
+
+# Copyright (c) 2021-2022, PostgreSQL Global Development Group
+
+# Very simple exercise of direct I/O: run a small workload with
+# debug_io_direct enabled for everything, including crash recovery.
+
+use strict;
+use warnings;
+use Fcntl;
+use PostgreSQL::Test::Cluster;
+use PostgreSQL::Test::Utils;
+use Test::More;
+
+# Only try on systems where we know direct I/O is supported, and where the
+# usual local file systems accept it or at least don't fail with an error.
+if ($^O ne 'linux' && $^O ne 'freebsd' && $^O ne 'MSWin32')
+{
+	plan skip_all => "no direct I/O support";
+}
+
+# Some file systems (for example tmpfs) refuse O_DIRECT; check that the one
+# we will be using doesn't.
+if ($^O ne 'MSWin32')
+{
+	my $f = "$PostgreSQL::Test::Utils::tmp_check/test_o_direct_file";
+	sysopen(my $fh, $f, O_RDWR | O_CREAT | Fcntl::O_DIRECT())
+	  or plan skip_all =>
+	  "pre-flight test if we can open a file with O_DIRECT failed: $!";
+	close $fh;
+	unlink $f;
+}
+
+my $node = PostgreSQL::Test::Cluster->new('main');
+$node->init;
+$node->append_conf(
+	'postgresql.conf', qq{
+debug_io_direct = 'data,wal,wal_init'
+shared_buffers = '256kB'
+temp_buffers = '100'
+});
+$node->start;
+
+# Do some work that is bound to generate shared and local reads and writes.
+$node->safe_psql('postgres',
+	'CREATE TABLE t1 AS SELECT 1 AS i FROM generate_series(1, 10000)');
+$node->safe_psql('postgres', 'CREATE TABLE t2count (i int)');
+$node->safe_psql(
+	'postgres', qq{
+BEGIN;
+CREATE TEMPORARY TABLE t2 AS SELECT 1 AS i FROM generate_series(1, 10000);
+UPDATE t2 SET i = i;
+INSERT INTO t2count SELECT count(*) FROM t2;
+COMMIT;
+});
+$node->safe_psql('postgres', 'UPDATE t1 SET i = i');
+is($node->safe_psql('postgres', 'SELECT count(*) FROM t1'),
+	'10000', "read back from shared");
+is($node->safe_psql('postgres', 'SELECT * FROM t2count'),
+	'10000', "read back from local");
+
+# Replay the WAL written with O_DIRECT
+$node->stop('immediate');
+$node->start;
+is($node->safe_psql('postgres', 'SELECT count(*) FROM t1'),
+	'10000', "read back from shared after crash recovery");
+
+$node->stop;
+
+done_testing();
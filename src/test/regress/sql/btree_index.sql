@@ -242,3 +242,86 @@ CREATE TABLE btree_part (id int4) PARTITION BY RANGE (id);
 CREATE INDEX btree_part_idx ON btree_part(id);
 ALTER INDEX btree_part_idx ALTER COLUMN id SET (n_distinct=100);
 DROP TABLE btree_part;
+
+--
+-- Test scans with an equality key on the second index column only.  These
+-- skip ahead within leading column groups that span several leaf pages.
+--
+CREATE TABLE btree_skip (a int4, b int4);
+INSERT INTO btree_skip SELECT a, b
+  FROM generate_series(1, 4) a, generate_series(1, 2000) b;
+INSERT INTO btree_skip SELECT NULL, b FROM generate_series(1, 2000) b;
+INSERT INTO btree_skip SELECT a, NULL FROM generate_series(1, 4) a;
+CREATE INDEX btree_skip_idx ON btree_skip (a, b);
+ANALYZE btree_skip;
+
+set enable_seqscan to false;
+set enable_bitmapscan to false;
+set enable_indexonlyscan to false;
+explain (costs off)
+select a, b from btree_skip where b = 1 order by a;
+-- first, last and middle member of each group, and no match at all
+select a, b from btree_skip where b = 1 order by a;
+select a, b from btree_skip where b = 2000 order by a;
+select a, b from btree_skip where b = 1001 order by a;
+select a, b from btree_skip where b = 0 order by a;
+select a, b from btree_skip where b = 2001 order by a;
+-- backward scans don't skip, but must give the same results
+explain (costs off)
+select a, b from btree_skip where b = 1 order by a desc;
+select a, b from btree_skip where b = 1 order by a desc;
+select a, b from btree_skip where b = 2000 order by a desc;
+
+-- the same with descending columns
+DROP INDEX btree_skip_idx;
+CREATE INDEX btree_skip_idx ON btree_skip (a DESC, b DESC);
+explain (costs off)
+select a, b from btree_skip where b = 1 order by a desc;
+select a, b from btree_skip where b = 1 order by a desc;
+select a, b from btree_skip where b = 2000 order by a desc;
+select a, b from btree_skip where b = 1001 order by a desc;
+select a, b from btree_skip where b = 0 order by a desc;
+select a, b from btree_skip where b = 2001 order by a desc;
+
+-- compare with the results without the index
+reset enable_seqscan;
+set enable_indexscan to false;
+select a, b from btree_skip where b = 1 order by a;
+select a, b from btree_skip where b = 2000 order by a;
+select a, b from btree_skip where b = 1001 order by a;
+select a, b from btree_skip where b = 1 order by a desc;
+select a, b from btree_skip where b = 2000 order by a desc;
+select a, b from btree_skip where b = 1001 order by a desc;
+
+reset enable_indexscan;
+reset enable_bitmapscan;
+reset enable_indexonlyscan;
+DROP TABLE btree_skip;
+
+--
+-- Index-only scans check heap pages whose visibility map bit isn't set as a
+-- whole, and skip heap fetches for the rest of a page that is entirely
+-- visible to them.  Pages 0-2 are all-visible, pages 3 and 5 are visible
+-- to us but not in the visibility map, and page 4 has a deleted tuple.
+--
+create temp table ios_pages (a int) with (autovacuum_enabled = off);
+create index ios_pages_a on ios_pages (a);
+insert into ios_pages select generate_series(1, 678);
+vacuum ios_pages;
+insert into ios_pages select generate_series(679, 1356);
+delete from ios_pages where a = 1000;
+set enable_seqscan to false;
+set enable_bitmapscan to false;
+-- two heap fetches each for pages 3 and 5, all of page 4
+explain (analyze, costs off, timing off, summary off)
+select count(*), sum(a) from ios_pages where a > 0;
+select count(*), sum(a) from ios_pages where a > 0;
+-- not done at serializable isolation level
+begin isolation level serializable;
+explain (analyze, costs off, timing off, summary off)
+select count(*), sum(a) from ios_pages where a > 0;
+select count(*), sum(a) from ios_pages where a > 0;
+commit;
+reset enable_seqscan;
+reset enable_bitmapscan;
+drop table ios_pages;
@@ -247,6 +247,36 @@ REINDEX INDEX hash_split_index;
 -- Clean up.
 DROP TABLE hash_split_heap;
 
+-- Parallel build of a hash index that is large enough to be sorted.  As with
+-- the serial build in create_index.sql, force tuplesort using a low
+-- maintenance_work_mem setting and fillfactor.  Setting parallel_workers
+-- lifts the planner's memory requirement for each worker.
+ALTER TABLE hash_i4_heap SET (parallel_workers = 2);
+SET maintenance_work_mem = '1MB';
+SET max_parallel_maintenance_workers = 2;
+SET client_min_messages = DEBUG1;
+CREATE INDEX hash_parallel_index ON hash_i4_heap USING hash (seqno int4_ops)
+  WITH (fillfactor = 10);
+-- A hash index that is not sorted is always built serially.
+CREATE INDEX hash_serial_index ON hash_i4_heap USING hash (seqno int4_ops);
+RESET client_min_messages;
+DROP INDEX hash_serial_index;
+RESET maintenance_work_mem;
+RESET max_parallel_maintenance_workers;
+ALTER TABLE hash_i4_heap RESET (parallel_workers);
+
+-- Check that every row can be found through the index.
+SET enable_seqscan = OFF;
+SET enable_bitmapscan = OFF;
+EXPLAIN (COSTS OFF)
+SELECT count(*) FROM hash_i4_heap WHERE seqno = 1234;
+SELECT count(*) FROM hash_i4_heap WHERE seqno = 1234;
+SELECT count(*) FROM hash_i4_heap h
+  WHERE EXISTS (SELECT 1 FROM hash_i4_heap i WHERE i.seqno = h.seqno);
+RESET enable_seqscan;
+RESET enable_bitmapscan;
+DROP INDEX hash_parallel_index;
+
 -- Index on temp table.
 CREATE TEMP TABLE hash_temp_heap (x int, y int);
 INSERT INTO hash_temp_heap VALUES (1,1);
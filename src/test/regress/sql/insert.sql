@@ -597,3 +597,19 @@ alter table returningwrtest2 drop c;
 alter table returningwrtest attach partition returningwrtest2 for values in (2);
 insert into returningwrtest values (2, 'foo') returning returningwrtest;
 drop table returningwrtest;
+
+-- check that tuple routing's cache of the last partition found doesn't
+-- misroute tuples at partition boundaries
+create table routecache_r (a int) partition by range (a);
+create table routecache_r1 partition of routecache_r for values from (minvalue) to (50);
+create table routecache_r2 partition of routecache_r for values from (50) to (100);
+create table routecache_r3 partition of routecache_r default;
+insert into routecache_r select i from generate_series(1, 150) i;
+select tableoid::regclass, count(*), min(a), max(a) from routecache_r group by 1 order by 1;
+drop table routecache_r;
+create table routecache_l (a int) partition by list (a);
+create table routecache_l1 partition of routecache_l for values in (1, 2);
+create table routecache_l2 partition of routecache_l for values in (3);
+insert into routecache_l select 1 + (i / 20) % 3 from generate_series(0, 99) i;
+select tableoid::regclass, count(*), min(a), max(a) from routecache_l group by 1 order by 1;
+drop table routecache_l;
@@ -2298,3 +2298,41 @@ where exists (select 1 from j3
       and t1.unique1 < 1;
 
 drop table j3;
+
+--
+-- test a nestloop materializing its inner side at runtime, when the outer
+-- side returns many more rows than estimated
+--
+create function nl_adapt_outer() returns setof int language plpgsql rows 1
+  as $$ begin return query select generate_series(1, 100); end; $$;
+create temp table nl_adapt_inner as
+  select g * 2 as a from generate_series(1, 1000) g;
+analyze nl_adapt_inner;
+
+begin;
+set local enable_hashjoin = off;
+set local enable_mergejoin = off;
+set local enable_material = off;
+
+explain (analyze, costs off, timing off, summary off)
+select count(*) from nl_adapt_outer() f(x)
+  join nl_adapt_inner t on f.x = t.a;
+explain (analyze, costs off, timing off, summary off)
+select count(*) from nl_adapt_outer() f(x)
+  where exists (select 1 from nl_adapt_inner t where f.x = t.a);
+explain (analyze, costs off, timing off, summary off)
+select count(*) from nl_adapt_outer() f(x)
+  where not exists (select 1 from nl_adapt_inner t where f.x = t.a);
+
+-- without it, the inner side is scanned once per outer row
+set local enable_adaptive_material = off;
+explain (analyze, costs off, timing off, summary off)
+select count(*) from nl_adapt_outer() f(x)
+  join nl_adapt_inner t on f.x = t.a;
+explain (analyze, costs off, timing off, summary off)
+select count(*) from nl_adapt_outer() f(x)
+  where exists (select 1 from nl_adapt_inner t where f.x = t.a);
+rollback;
+
+drop table nl_adapt_inner;
+drop function nl_adapt_outer();
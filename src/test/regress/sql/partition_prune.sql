@@ -1187,3 +1187,48 @@ explain (costs off) select * from hp_contradict_test where a === 1 and b === 1 a
 drop table hp_contradict_test;
 drop operator class part_test_int4_ops2 using hash;
 drop operator ===(int4, int4);
+
+--
+-- Check that executing a cached generic plan locks only those partitions
+-- that survive initial pruning
+--
+create table lockprune (a int) partition by list (a);
+create table lockprune1 partition of lockprune for values in (1);
+create table lockprune2 partition of lockprune for values in (2);
+create table lockprune3 partition of lockprune for values in (3);
+prepare lockprune_q (int) as select * from lockprune where a = $1;
+-- the first execution builds the generic plan, locking all partitions
+execute lockprune_q (1);
+begin;
+execute lockprune_q (2);
+select relation::regclass::text as rel from pg_locks
+  where locktype = 'relation' and pid = pg_backend_pid()
+    and relation::regclass::text like 'lockprune%'
+  order by 1;
+commit;
+deallocate lockprune_q;
+drop table lockprune;
+
+-- Sub-partitioned tables scanned through a nested ordered Append must be
+-- locked before pruning, even though they have a subplan of their own
+set enable_sort to 0;
+create table lockprune_ord (a int, b int) partition by range (a);
+create table lockprune_ord1 partition of lockprune_ord for values from (0) to (100) partition by list (b);
+create table lockprune_ord1_1 partition of lockprune_ord1 for values in (1);
+create table lockprune_ord1_2 partition of lockprune_ord1 for values in (2);
+create table lockprune_ord1_3 partition of lockprune_ord1 for values in (3);
+create table lockprune_ord2 partition of lockprune_ord for values from (100) to (200);
+create index on lockprune_ord (a);
+prepare lockprune_ord_q (int, int) as
+  select * from lockprune_ord where a < $1 and b = $2 order by a;
+explain (costs off) execute lockprune_ord_q (50, 2);
+begin;
+execute lockprune_ord_q (50, 2);
+select relation::regclass::text as rel from pg_locks
+  where locktype = 'relation' and pid = pg_backend_pid()
+    and relation::regclass::text like 'lockprune%'
+  order by 1;
+commit;
+deallocate lockprune_ord_q;
+reset enable_sort;
+drop table lockprune_ord;